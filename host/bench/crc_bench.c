@@ -0,0 +1,235 @@
+/*
+ * crc_bench.c
+ *
+ * host benchmark of rs485 crc, the crc module is built once for each slice count
+ * and compared with a bitwise implementation.
+ *
+ * usage : crc_bench [-n iterations] [frame size ...]
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ */
+
+#include <rtthread.h>
+#include <rs485_crc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_BUF_SIZE      4096
+#define BENCH_BYTES         (64 * 1024 * 1024)  //bytes processed by each measurement
+
+typedef rt_uint16_t (*crc16_fn_t)(rt_uint16_t crc, const void *buf, int len);
+typedef rt_uint32_t (*crc32_fn_t)(rt_uint32_t crc, const void *buf, int len);
+
+#define CRC_VARIANT_DECL(n) \
+    rt_uint16_t rs485_crc16_s##n(rt_uint16_t crc, const void *buf, int len); \
+    rt_uint32_t rs485_crc32_s##n(rt_uint32_t crc, const void *buf, int len);
+
+CRC_VARIANT_DECL(1)
+CRC_VARIANT_DECL(4)
+CRC_VARIANT_DECL(8)
+
+static rt_uint16_t crc16_bitwise(rt_uint16_t crc, const void *buf, int len)
+{
+    const rt_uint8_t *p = buf;
+    
+    while (len-- > 0)
+    {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+        }
+    }
+    
+    return(crc);
+}
+
+static rt_uint32_t crc32_bitwise(rt_uint32_t crc, const void *buf, int len)
+{
+    const rt_uint8_t *p = buf;
+    
+    crc = ~crc;
+    while (len-- > 0)
+    {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+        }
+    }
+    
+    return(~crc);
+}
+
+static const struct
+{
+    const char *name;
+    crc16_fn_t crc16;
+    crc32_fn_t crc32;
+} variants[] = 
+{
+    {"bitwise",  crc16_bitwise,   crc32_bitwise},
+    {"table",    rs485_crc16_s1,  rs485_crc32_s1},
+    {"slice-4",  rs485_crc16_s4,  rs485_crc32_s4},
+    {"slice-8",  rs485_crc16_s8,  rs485_crc32_s8},
+};
+
+#define VARIANT_NUM     (sizeof(variants) / sizeof(variants[0]))
+
+static rt_uint8_t buf[BENCH_BUF_SIZE + 4];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec * 1e9 + ts.tv_nsec);
+}
+
+/* every variant should give the same result, in one pass and in parts, and the frame residue */
+static int check_variants(void)
+{
+    rt_uint16_t ref16 = crc16_bitwise(RS485_CRC16_INIT, buf, 1000);
+    rt_uint32_t ref32 = crc32_bitwise(RS485_CRC32_INIT, buf, 1000);
+    
+    if (crc32_bitwise(RS485_CRC32_INIT, "123456789", 9) != 0xCBF43926 
+        || crc16_bitwise(RS485_CRC16_INIT, "123456789", 9) != 0x4B37)
+    {
+        printf("bitwise reference check fail.\n");
+        return(-1);
+    }
+    
+    for (int i = 1; i < VARIANT_NUM; i++)
+    {
+        rt_uint8_t frame[1004];
+        rt_uint16_t c16 = variants[i].crc16(variants[i].crc16(RS485_CRC16_INIT, buf, 13), buf + 13, 987);
+        rt_uint32_t c32 = variants[i].crc32(variants[i].crc32(RS485_CRC32_INIT, buf, 13), buf + 13, 987);
+        
+        if (variants[i].crc16(RS485_CRC16_INIT, buf, 1000) != ref16 || c16 != ref16 
+            || variants[i].crc32(RS485_CRC32_INIT, buf, 1000) != ref32 || c32 != ref32)
+        {
+            printf("%s check fail.\n", variants[i].name);
+            return(-1);
+        }
+        
+        memcpy(frame, buf, 1000);
+        frame[1000] = (rt_uint8_t)ref32;
+        frame[1001] = (rt_uint8_t)(ref32 >> 8);
+        frame[1002] = (rt_uint8_t)(ref32 >> 16);
+        frame[1003] = (rt_uint8_t)(ref32 >> 24);
+        if (variants[i].crc32(RS485_CRC32_INIT, frame, 1004) != RS485_CRC32_RESIDUE)
+        {
+            printf("%s crc32 residue check fail.\n", variants[i].name);
+            return(-1);
+        }
+        frame[1000] = (rt_uint8_t)ref16;
+        frame[1001] = (rt_uint8_t)(ref16 >> 8);
+        if (variants[i].crc16(RS485_CRC16_INIT, frame, 1002) != RS485_CRC16_RESIDUE)
+        {
+            printf("%s crc16 residue check fail.\n", variants[i].name);
+            return(-1);
+        }
+    }
+    
+    return(0);
+}
+
+static void bench_size(int size, int iterations)
+{
+    volatile rt_uint32_t sink = 0;
+    double base16 = 0, base32 = 0;
+    
+    printf("frame %d bytes :\n", size);
+    for (int v = 0; v < VARIANT_NUM; v++)
+    {
+        int loops = BENCH_BYTES / size / ((v == 0) ? 8 : 1) / iterations + 1;
+        double best16 = 0, best32 = 0;
+        
+        for (int it = 0; it < iterations; it++)
+        {
+            double t0 = now_ns();
+            for (int i = 0; i < loops; i++)
+            {
+                sink += variants[v].crc16(RS485_CRC16_INIT, buf + (i & 3), size);
+            }
+            double t1 = now_ns();
+            for (int i = 0; i < loops; i++)
+            {
+                sink += variants[v].crc32(RS485_CRC32_INIT, buf + (i & 3), size);
+            }
+            double t2 = now_ns();
+            double ns16 = (t1 - t0) / loops;
+            double ns32 = (t2 - t1) / loops;
+            if (it == 0 || ns16 < best16)
+            {
+                best16 = ns16;
+            }
+            if (it == 0 || ns32 < best32)
+            {
+                best32 = ns32;
+            }
+        }
+        if (v == 0)
+        {
+            base16 = best16;
+            base32 = best32;
+        }
+        printf("  %-8s : crc16 %9.1f ns %7.1f MB/s %5.1fx   crc32 %9.1f ns %7.1f MB/s %5.1fx\n", variants[v].name,
+                best16, size * 1e3 / best16, base16 / best16, best32, size * 1e3 / best32, base32 / best32);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const int default_sizes[] = {8, 64, 256, 4096};
+    int sizes[16];
+    int size_num = 0;
+    int iterations = 5;
+    
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+        }
+        else if (size_num < 16)
+        {
+            sizes[size_num++] = atoi(argv[i]);
+        }
+    }
+    if (size_num == 0)
+    {
+        for (int i = 0; i < sizeof(default_sizes) / sizeof(int); i++)
+        {
+            sizes[size_num++] = default_sizes[i];
+        }
+    }
+    for (int i = 0; i < size_num; i++)
+    {
+        if (sizes[i] <= 0 || sizes[i] > BENCH_BUF_SIZE || iterations <= 0)
+        {
+            printf("usage : crc_bench [-n iterations] [frame size ...]\n");
+            return(1);
+        }
+    }
+    
+    srand(1);
+    for (int i = 0; i < sizeof(buf); i++)
+    {
+        buf[i] = (rt_uint8_t)rand();
+    }
+    if (check_variants() != 0)
+    {
+        return(1);
+    }
+    
+    for (int i = 0; i < size_num; i++)
+    {
+        bench_size(sizes[i], iterations);
+    }
+    
+    return(0);
+}
@@ -0,0 +1,381 @@
+/*
+ * rs485_bench.c
+ *
+ * host benchmark of rs485 package hot path.
+ * the package is linked against the host shim, the serial device is a pty pair
+ * paced at the configured baud rate, a far end node runs in its own thread.
+ *
+ * usage : rs485_bench [-n iterations] [-s frame size] [-d] [baudrate ...]
+ *         -d : connect with dma receive
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       add batched transactions
+ * 2026-10-17     qiyongzhong       add receive completed by frame predicate
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <rs485.h>
+#include <pty_serial.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SERIAL        "uart1"
+#define BENCH_PIN           5
+#define BENCH_LEVEL         1
+#define BENCH_BUF_SIZE      1024
+#define BENCH_BLOCK_SIZE    256
+#define BENCH_BLOCK_US      1000000     //wire time spent on the throughput test of each baudrate
+#define BENCH_RECV_TMO      1000
+#define BENCH_BATCH_NUM     32          //transactions of a polling cycle
+
+enum
+{
+    PEER_IDLE = 0,
+    PEER_SINK,          //discard everything received
+    PEER_ECHO,          //send back every received chunk
+    PEER_SOURCE,        //send one frame on each go
+};
+
+static rt_device_t bench_dev = RT_NULL;
+static pthread_mutex_t peer_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t peer_cond = PTHREAD_COND_INITIALIZER;
+static volatile int peer_mode = PEER_IDLE;
+static volatile int peer_go = 0;
+static int frame_size = 16;
+
+static void peer_entry(void *args)
+{
+    static rt_uint8_t buf[BENCH_BUF_SIZE];
+    
+    while (1)
+    {
+        int mode = peer_mode;
+        if (mode == PEER_SOURCE)
+        {
+            pthread_mutex_lock(&peer_mtx);
+            while (peer_go == 0 && peer_mode == PEER_SOURCE)
+            {
+                pthread_cond_wait(&peer_cond, &peer_mtx);
+            }
+            peer_go = 0;
+            pthread_mutex_unlock(&peer_mtx);
+            if (peer_mode != PEER_SOURCE)
+            {
+                continue;
+            }
+            rt_thread_mdelay(1);//let the receiver enter its wait
+            for (int i = 0; i < frame_size; i++)
+            {
+                buf[i] = (rt_uint8_t)i;
+            }
+            pty_serial_peer_send(bench_dev, buf, frame_size);
+            continue;
+        }
+        
+        int len = pty_serial_peer_recv(bench_dev, buf, sizeof(buf), 10);
+        if (len > 0 && mode == PEER_ECHO)
+        {
+            pty_serial_peer_send(bench_dev, buf, len);
+        }
+    }
+}
+
+static void peer_set_mode(int mode)
+{
+    pthread_mutex_lock(&peer_mtx);
+    peer_mode = mode;
+    peer_go = 0;
+    pthread_cond_broadcast(&peer_cond);
+    pthread_mutex_unlock(&peer_mtx);
+    rt_thread_mdelay(20);//let the far end settle and drain
+}
+
+static void peer_kick(void)
+{
+    pthread_mutex_lock(&peer_mtx);
+    peer_go = 1;
+    pthread_cond_broadcast(&peer_cond);
+    pthread_mutex_unlock(&peer_mtx);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    rt_uint32_t x = *(const rt_uint32_t *)a;
+    rt_uint32_t y = *(const rt_uint32_t *)b;
+    return((x > y) - (x < y));
+}
+
+static void show_percentiles(const char *name, rt_uint32_t *samples, int num, int fails)
+{
+    if (num == 0)
+    {
+        rt_kprintf("  %-22s : no samples, %d failed\n", name, fails);
+        return;
+    }
+    qsort(samples, num, sizeof(rt_uint32_t), cmp_u32);
+    rt_kprintf("  %-22s : p50 %7u us  p90 %7u us  p99 %7u us  max %7u us  (%d ok, %d failed)\n", name,
+                samples[num / 2], samples[num * 9 / 10], samples[num * 99 / 100], samples[num - 1], num, fails);
+}
+
+static void bench_send(rs485_inst_t *hinst)
+{
+    static rt_uint8_t buf[BENCH_BLOCK_SIZE];
+    rt_uint32_t wire_us = pty_serial_wire_us(bench_dev, sizeof(buf));
+    int count = BENCH_BLOCK_US / wire_us;
+    rt_uint64_t start, used;
+    
+    if (count < 4)
+    {
+        count = 4;
+    }
+    
+    peer_set_mode(PEER_SINK);
+    start = pty_serial_now_us();
+    for (int i = 0; i < count; i++)
+    {
+        rs485_send(hinst, buf, sizeof(buf));
+    }
+    used = pty_serial_now_us() - start;
+    
+    rt_kprintf("  %-22s : %8.0f bytes/s, %5.1f%% of wire speed (%d x %d bytes)\n", "send throughput",
+                (double)count * sizeof(buf) * 1000000.0 / used, 
+                (double)count * wire_us * 100.0 / used, count, (int)sizeof(buf));
+}
+
+static void bench_recv(rs485_inst_t *hinst, int iterations, rt_uint32_t *samples)
+{
+    static rt_uint8_t buf[BENCH_BUF_SIZE];
+    int num = 0, fails = 0;
+    
+    peer_set_mode(PEER_SOURCE);
+    for (int i = 0; i < iterations; i++)
+    {
+        peer_kick();
+        int len = rs485_recv(hinst, buf, sizeof(buf));
+        rt_uint64_t done = pty_serial_now_us();
+        if (len != frame_size)
+        {
+            fails++;
+            continue;
+        }
+        samples[num++] = (rt_uint32_t)(done - pty_serial_last_rx_us(bench_dev));
+    }
+    show_percentiles("recv last byte->return", samples, num, fails);
+}
+
+static int frame_done(const rt_uint8_t *buf, int len, void *ctx)
+{
+    return((len >= frame_size) ? frame_size : 0);
+}
+
+static void bench_recv_ex(rs485_inst_t *hinst, int iterations, rt_uint32_t *samples)
+{
+    static rt_uint8_t buf[BENCH_BUF_SIZE];
+    int num = 0, fails = 0;
+    
+    peer_set_mode(PEER_SOURCE);
+    for (int i = 0; i < iterations; i++)
+    {
+        peer_kick();
+        int len = rs485_recv_ex(hinst, buf, sizeof(buf), frame_done, RT_NULL);
+        rt_uint64_t done = pty_serial_now_us();
+        if (len != frame_size)
+        {
+            fails++;
+            continue;
+        }
+        samples[num++] = (rt_uint32_t)(done - pty_serial_last_rx_us(bench_dev));
+    }
+    show_percentiles("recv_ex last byte->ret", samples, num, fails);
+}
+
+static void bench_send_then_recv(rs485_inst_t *hinst, int iterations, rt_uint32_t *samples)
+{
+    static rt_uint8_t tx[BENCH_BUF_SIZE];
+    static rt_uint8_t rx[BENCH_BUF_SIZE];
+    rt_uint32_t wire_us = pty_serial_wire_us(bench_dev, frame_size) * 2;
+    int num = 0, fails = 0;
+    
+    for (int i = 0; i < frame_size; i++)
+    {
+        tx[i] = (rt_uint8_t)(i + 1);
+    }
+    
+    peer_set_mode(PEER_ECHO);
+    for (int i = 0; i < iterations; i++)
+    {
+        rt_uint64_t start = pty_serial_now_us();
+        int len = rs485_send_then_recv(hinst, tx, frame_size, rx, sizeof(rx));
+        rt_uint32_t used = (rt_uint32_t)(pty_serial_now_us() - start);
+        if (len != frame_size || memcmp(tx, rx, len) != 0)
+        {
+            fails++;
+            continue;
+        }
+        samples[num++] = used;
+    }
+    show_percentiles("send_then_recv rtt", samples, num, fails);
+    for (int i = 0; i < num; i++)
+    {
+        samples[i] = (samples[i] > wire_us) ? (samples[i] - wire_us) : 0;
+    }
+    show_percentiles("  rtt minus wire time", samples, num, 0);
+    
+    num = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        rt_uint64_t start = pty_serial_now_us();
+        int len = rs485_send_then_recv_ex(hinst, tx, frame_size, rx, sizeof(rx), frame_done, RT_NULL);
+        rt_uint32_t used = (rt_uint32_t)(pty_serial_now_us() - start);
+        if (len != frame_size || memcmp(tx, rx, len) != 0)
+        {
+            continue;
+        }
+        samples[num++] = (used > wire_us) ? (used - wire_us) : 0;
+    }
+    show_percentiles("  _ex rtt minus wire", samples, num, iterations - num);
+}
+
+static void bench_batch(rs485_inst_t *hinst, int iterations, rt_uint32_t *samples)
+{
+    static rt_uint8_t tx[BENCH_BATCH_NUM][BENCH_BUF_SIZE];
+    static rt_uint8_t rx[BENCH_BATCH_NUM][BENCH_BUF_SIZE];
+    static rs485_xfer_t xfers[BENCH_BATCH_NUM];
+    rt_uint32_t wire_us = pty_serial_wire_us(bench_dev, frame_size) * 2 * BENCH_BATCH_NUM;
+    int cycles = (iterations + 9) / 10;
+    int num = 0, fails = 0;
+    
+    for (int i = 0; i < BENCH_BATCH_NUM; i++)
+    {
+        for (int j = 0; j < frame_size; j++)
+        {
+            tx[i][j] = (rt_uint8_t)(i + j);
+        }
+    }
+    
+    peer_set_mode(PEER_ECHO);
+    for (int c = 0; c < cycles; c++)//polling cycle by a loop of send_then_recv
+    {
+        rt_uint64_t start = pty_serial_now_us();
+        int ok = 0;
+        for (int i = 0; i < BENCH_BATCH_NUM; i++)
+        {
+            ok += (rs485_send_then_recv(hinst, tx[i], frame_size, rx[i], BENCH_BUF_SIZE) == frame_size);
+        }
+        if (ok != BENCH_BATCH_NUM)
+        {
+            fails++;
+            continue;
+        }
+        samples[num++] = (rt_uint32_t)(pty_serial_now_us() - start);
+    }
+    show_percentiles("loop cycle", samples, num, fails);
+    
+    num = 0;
+    fails = 0;
+    for (int c = 0; c < cycles; c++)//the same cycle by one batch
+    {
+        rt_uint64_t start;
+        for (int i = 0; i < BENCH_BATCH_NUM; i++)
+        {
+            xfers[i].send_buf = tx[i];
+            xfers[i].send_len = frame_size;
+            xfers[i].recv_buf = rx[i];
+            xfers[i].recv_size = BENCH_BUF_SIZE;
+            xfers[i].timeout = 0;
+        }
+        start = pty_serial_now_us();
+        if (rs485_transact_batch(hinst, xfers, BENCH_BATCH_NUM) != BENCH_BATCH_NUM)
+        {
+            fails++;
+            continue;
+        }
+        samples[num++] = (rt_uint32_t)(pty_serial_now_us() - start);
+    }
+    show_percentiles("batch cycle", samples, num, fails);
+    rt_kprintf("  %-22s : %u us for %d transactions\n", "  cycle wire time", wire_us, BENCH_BATCH_NUM);
+}
+
+int main(int argc, char **argv)
+{
+    static const int default_bauds[] = {9600, 115200, 921600};
+    int bauds[16];
+    int baud_num = 0;
+    int iterations = 50;
+    int flags = 0;
+    rt_uint32_t *samples;
+    rs485_inst_t *hinst;
+    rt_thread_t tid;
+    
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            frame_size = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-d") == 0)
+        {
+            flags |= RS485_CONN_DMA_RX;
+        }
+        else if (baud_num < 16)
+        {
+            bauds[baud_num++] = atoi(argv[i]);
+        }
+    }
+    if (baud_num == 0)
+    {
+        for (int i = 0; i < sizeof(default_bauds) / sizeof(int); i++)
+        {
+            bauds[baud_num++] = default_bauds[i];
+        }
+    }
+    if (iterations <= 0 || frame_size <= 0 || frame_size > BENCH_BUF_SIZE)
+    {
+        rt_kprintf("usage : rs485_bench [-n iterations] [-s frame size] [-d] [baudrate ...]\n");
+        return(1);
+    }
+
+    samples = rt_malloc(iterations * sizeof(rt_uint32_t));
+    bench_dev = pty_serial_create(BENCH_SERIAL);
+    if (samples == RT_NULL || bench_dev == RT_NULL)
+    {
+        rt_kprintf("bench init fail.\n");
+        return(1);
+    }
+    
+    hinst = rs485_create(BENCH_SERIAL, bauds[0], 0, BENCH_PIN, BENCH_LEVEL);
+    if (hinst == RT_NULL || rs485_connect_ex(hinst, flags) != RT_EOK)
+    {
+        rt_kprintf("rs485 instance init fail.\n");
+        return(1);
+    }
+    rs485_set_recv_tmo(hinst, BENCH_RECV_TMO);
+    
+    tid = rt_thread_create("peer", peer_entry, RT_NULL, 1024, 8, 20);
+    rt_thread_startup(tid);
+    
+    for (int i = 0; i < baud_num; i++)
+    {
+        rs485_config(hinst, bauds[i], 8, 0, 0);
+        rt_kprintf("baudrate %d, frame %d bytes, wire time %u us :\n", bauds[i], frame_size, 
+                    pty_serial_wire_us(bench_dev, frame_size));
+        bench_recv(hinst, iterations, samples);
+        bench_recv_ex(hinst, iterations, samples);
+        bench_send_then_recv(hinst, iterations, samples);
+        bench_batch(hinst, iterations, samples);
+        bench_send(hinst);
+    }
+    
+    peer_set_mode(PEER_IDLE);
+    rs485_destory(hinst);
+    rt_free(samples);
+    
+    return(0);
+}
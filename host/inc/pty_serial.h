@@ -0,0 +1,90 @@
+/*
+ * pty_serial.h
+ *
+ * host serial device backed by a pseudo terminal pair.
+ * the rs485 package opens the device side, the far end node is driven through the peer side.
+ * both directions are paced at the configured baud rate: a frame is delivered to the
+ * other side when its last stop bit would have left the wire.
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       add hardware direction control
+ */
+
+#ifndef __HOST_PTY_SERIAL_H__
+#define __HOST_PTY_SERIAL_H__
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* 
+ * @brief   create a pty backed serial device and register it
+ * @param   name        - device name
+ * @retval  device handle, NULL - error
+ */
+rt_device_t pty_serial_create(const char *name);
+
+/* 
+ * @brief   get wire time of datas at current serial config
+ * @param   dev         - device handle
+ * @param   size        - length of datas
+ * @retval  wire time, us
+ */
+rt_uint32_t pty_serial_wire_us(rt_device_t dev, rt_size_t size);
+
+/* 
+ * @brief   set whether the device supports hardware direction control, it does after created
+ * @param   dev         - device handle
+ * @param   cap         - 0--no support, 1--support
+ */
+void pty_serial_set_hw_de_cap(rt_device_t dev, int cap);
+
+/* 
+ * @brief   get whether the uart drives transceiver enable
+ * @param   dev         - device handle
+ * @retval  0--no, 1--yes
+ */
+int pty_serial_hw_de(rt_device_t dev);
+
+/* 
+ * @brief   send datas from the far end node, blocks for the wire time
+ * @param   dev         - device handle
+ * @param   buf         - datas addr
+ * @param   size        - length of datas
+ * @retval  >=0 - length of sent datas, <0 - error
+ */
+int pty_serial_peer_send(rt_device_t dev, const void *buf, int size);
+
+/* 
+ * @brief   receive datas at the far end node
+ * @param   dev         - device handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @param   tmo_ms      - wait timeout, <0 - wait forever
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int pty_serial_peer_recv(rt_device_t dev, void *buf, int size, int tmo_ms);
+
+/* 
+ * @brief   get the time the last datas entered the receive fifo of device side
+ * @param   dev         - device handle
+ * @retval  microseconds of host monotonic clock
+ */
+rt_uint64_t pty_serial_last_rx_us(rt_device_t dev);
+
+/* 
+ * @brief   get microseconds of host monotonic clock
+ * @retval  microseconds
+ */
+rt_uint64_t pty_serial_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,49 @@
+/*
+ * rtconfig.h
+ *
+ * host build configuration of rs485 package
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       enable stats
+ * 2026-10-17     qiyongzhong       enable trace
+ * 2026-10-17     qiyongzhong       enable poll scheduler
+ * 2026-10-17     qiyongzhong       enable adaptive response timeout
+ * 2026-10-17     qiyongzhong       enable receive ring
+ * 2026-10-17     qiyongzhong       enable hardware direction control
+ * 2026-10-17     qiyongzhong       build serial v2 backend by RS485_DEFS
+ * 2026-10-17     qiyongzhong       declare microsecond clock of pty serial
+ */
+
+#ifndef __HOST_RTCONFIG_H__
+#define __HOST_RTCONFIG_H__
+
+#define RT_NAME_MAX             8
+#define RT_TICK_PER_SECOND      1000
+#define RT_USING_SERIAL
+#define RT_USING_PIN
+
+#ifndef RT_SERIAL_RB_BUFSZ
+#define RT_SERIAL_RB_BUFSZ      4096
+#endif
+
+#define PKG_USING_RS485
+#define RS485_USING_FRAME_POOL
+#define RS485_USING_FRAME_HANDLER
+#define RS485_USING_MODBUS
+#define RS485_USING_MODBUS_SLAVE
+#define RS485_USING_STATS
+#define RS485_USING_TRACE
+#define RS485_USING_SCHED
+#define RS485_USING_RTO
+#define RS485_USING_US_CLOCK            //rs485_get_us is overridden by pty serial
+#ifdef RS485_USING_SERIAL_V2             //given by RS485_DEFS, the pty serial plays a serial v2 device
+#define RT_USING_SERIAL_V2
+#else
+#define RS485_USING_RX_RING
+#define RS485_RX_RING_SIZE      RT_SERIAL_RB_BUFSZ
+#endif
+#define RS485_USING_HW_DE
+
+#endif
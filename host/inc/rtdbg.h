@@ -0,0 +1,58 @@
+/*
+ * rtdbg.h
+ *
+ * host shim of the rt-thread debug log macros
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ */
+
+#ifndef __HOST_RTDBG_H__
+#define __HOST_RTDBG_H__
+
+#include <stdio.h>
+
+#define DBG_ERROR           0
+#define DBG_WARNING         1
+#define DBG_INFO            2
+#define DBG_LOG             3
+
+#ifndef DBG_TAG
+#define DBG_TAG             "DBG"
+#endif
+
+#ifndef DBG_LVL
+#define DBG_LVL             DBG_WARNING
+#endif
+
+#define dbg_log_line(lvl, fmt, ...) \
+    fprintf(stderr, "[" lvl "/" DBG_TAG "] " fmt "\n", ##__VA_ARGS__)
+
+#if (DBG_LVL >= DBG_LOG)
+#define LOG_D(fmt, ...)     dbg_log_line("D", fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(...)
+#endif
+
+#if (DBG_LVL >= DBG_INFO)
+#define LOG_I(fmt, ...)     dbg_log_line("I", fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(...)
+#endif
+
+#if (DBG_LVL >= DBG_WARNING)
+#define LOG_W(fmt, ...)     dbg_log_line("W", fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(...)
+#endif
+
+#if (DBG_LVL >= DBG_ERROR)
+#define LOG_E(fmt, ...)     dbg_log_line("E", fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(...)
+#endif
+
+#define LOG_RAW(...)        fprintf(stderr, __VA_ARGS__)
+
+#endif
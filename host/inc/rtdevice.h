@@ -0,0 +1,101 @@
+/*
+ * rtdevice.h
+ *
+ * host shim of the rt-thread serial and pin device api used by rs485 package
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       add serial v2 open flags and receive timeout control
+ */
+
+#ifndef __HOST_RTDEVICE_H__
+#define __HOST_RTDEVICE_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* 
+ * serial
+ */
+#define BAUD_RATE_9600          9600
+#define BAUD_RATE_115200        115200
+
+#define DATA_BITS_5             5
+#define DATA_BITS_6             6
+#define DATA_BITS_7             7
+#define DATA_BITS_8             8
+#define DATA_BITS_9             9
+
+#define STOP_BITS_1             0
+#define STOP_BITS_2             1
+
+#define PARITY_NONE             0
+#define PARITY_ODD              1
+#define PARITY_EVEN             2
+
+#define BIT_ORDER_LSB           0
+#define BIT_ORDER_MSB           1
+
+#define NRZ_NORMAL              0
+#define NRZ_INVERTED            1
+
+struct serial_configure
+{
+    rt_uint32_t baud_rate;
+
+    rt_uint32_t data_bits               :4;
+    rt_uint32_t stop_bits               :2;
+    rt_uint32_t parity                  :2;
+    rt_uint32_t bit_order               :1;
+    rt_uint32_t invert                  :1;
+    rt_uint32_t bufsz                   :16;
+    rt_uint32_t reserved                :6;
+};
+
+#define RT_SERIAL_CONFIG_DEFAULT           \
+{                                          \
+    BAUD_RATE_115200, /* 115200 bits/s */  \
+    DATA_BITS_8,      /* 8 databits */     \
+    STOP_BITS_1,      /* 1 stopbit */      \
+    PARITY_NONE,      /* No parity  */     \
+    BIT_ORDER_LSB,    /* LSB first sent */ \
+    NRZ_NORMAL,       /* Normal mode */    \
+    RT_SERIAL_RB_BUFSZ, /* Buffer size */  \
+    0                                      \
+}
+
+#ifdef RT_USING_SERIAL_V2
+#define RT_DEVICE_FLAG_RX_BLOCKING      0x1000
+#define RT_DEVICE_FLAG_RX_NON_BLOCKING  0x2000
+#define RT_DEVICE_FLAG_TX_BLOCKING      0x4000
+#define RT_DEVICE_FLAG_TX_NON_BLOCKING  0x8000
+
+#define RT_SERIAL_CTRL_SET_RX_TIMEOUT   0x41    //args is rt_int32_t ticks, blocking read returns when it elapses
+#define RT_SERIAL_CTRL_SET_TX_TIMEOUT   0x42
+#endif
+
+/* 
+ * pin
+ */
+#define PIN_LOW                 0x00
+#define PIN_HIGH                0x01
+
+#define PIN_MODE_OUTPUT         0x00
+#define PIN_MODE_INPUT          0x01
+#define PIN_MODE_INPUT_PULLUP   0x02
+#define PIN_MODE_INPUT_PULLDOWN 0x03
+#define PIN_MODE_OUTPUT_OD      0x04
+
+void rt_pin_mode(rt_base_t pin, rt_base_t mode);
+void rt_pin_write(rt_base_t pin, rt_base_t value);
+int  rt_pin_read(rt_base_t pin);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
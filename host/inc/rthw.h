@@ -0,0 +1,35 @@
+/*
+ * rthw.h
+ *
+ * host shim of the rt-thread cpu port api used by rs485 package
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       add memory barrier
+ */
+
+#ifndef __HOST_RTHW_H__
+#define __HOST_RTHW_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* interrupts are emulated by one global recursive lock, the serial receive thread takes it too */
+rt_base_t rt_hw_interrupt_disable(void);
+void rt_hw_interrupt_enable(rt_base_t level);
+
+/* busy wait, like the cpu port implementation */
+void rt_hw_us_delay(rt_uint32_t us);
+
+/* data memory barrier, the receive thread of pty serial runs on another cpu */
+#define rt_hw_dmb()     __sync_synchronize()
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,276 @@
+/*
+ * rtthread.h
+ *
+ * host shim of the rt-thread kernel api used by rs485 package,
+ * implemented on posix threads so the package can be built and measured on linux.
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       add timer
+ * 2026-10-17     qiyongzhong       add static thread
+ */
+
+#ifndef __HOST_RTTHREAD_H__
+#define __HOST_RTTHREAD_H__
+
+#include <rtconfig.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef int8_t                  rt_int8_t;
+typedef int16_t                 rt_int16_t;
+typedef int32_t                 rt_int32_t;
+typedef int64_t                 rt_int64_t;
+typedef uint8_t                 rt_uint8_t;
+typedef uint16_t                rt_uint16_t;
+typedef uint32_t                rt_uint32_t;
+typedef uint64_t                rt_uint64_t;
+typedef long                    rt_base_t;
+typedef unsigned long           rt_ubase_t;
+typedef rt_base_t               rt_bool_t;
+typedef rt_base_t               rt_err_t;
+typedef rt_ubase_t              rt_size_t;
+typedef rt_base_t               rt_off_t;
+typedef rt_uint32_t             rt_tick_t;
+
+#define RT_TRUE                 1
+#define RT_FALSE                0
+#define RT_NULL                 0
+
+#define RT_EOK                  0
+#define RT_ERROR                1
+#define RT_ETIMEOUT             2
+#define RT_EFULL                3
+#define RT_EEMPTY               4
+#define RT_ENOMEM               5
+#define RT_ENOSYS               6
+#define RT_EBUSY                7
+#define RT_EIO                  8
+#define RT_EINTR                9
+#define RT_EINVAL               10
+
+#define RT_WAITING_FOREVER      -1
+#define RT_WAITING_NO           0
+
+#define RT_IPC_FLAG_FIFO        0x00
+#define RT_IPC_FLAG_PRIO        0x01
+#define RT_IPC_CMD_RESET        0x01
+
+#define RT_EVENT_FLAG_AND       0x01
+#define RT_EVENT_FLAG_OR        0x02
+#define RT_EVENT_FLAG_CLEAR     0x04
+
+#define RT_TIMER_FLAG_ONE_SHOT  0x0
+#define RT_TIMER_FLAG_PERIODIC  0x2
+#define RT_TIMER_FLAG_HARD_TIMER 0x0
+#define RT_TIMER_FLAG_SOFT_TIMER 0x4
+
+#define RT_TIMER_CTRL_SET_TIME  0x0
+#define RT_TIMER_CTRL_GET_TIME  0x1
+
+#define RT_WEAK                 __attribute__((weak))
+#define rt_weak                 RT_WEAK
+#define rt_inline               static __inline
+#define RT_ASSERT(x)            assert(x)
+
+/* auto initialization and shell commands are not run on the host, only keep the symbols referenced */
+#define INIT_EXPORT_KEEP(fn, tag)           static const void *__rt_keep_##tag##_##fn __attribute__((used)) = (const void *)(fn)
+#define INIT_BOARD_EXPORT(fn)               INIT_EXPORT_KEEP(fn, board)
+#define INIT_DEVICE_EXPORT(fn)              INIT_EXPORT_KEEP(fn, device)
+#define INIT_COMPONENT_EXPORT(fn)           INIT_EXPORT_KEEP(fn, component)
+#define INIT_ENV_EXPORT(fn)                 INIT_EXPORT_KEEP(fn, env)
+#define INIT_APP_EXPORT(fn)                 INIT_EXPORT_KEEP(fn, app)
+#define MSH_CMD_EXPORT(cmd, desc)           INIT_EXPORT_KEEP(cmd, msh)
+#define MSH_CMD_EXPORT_ALIAS(cmd, a, desc)  INIT_EXPORT_KEEP(cmd, msh)
+
+/* 
+ * kernel objects
+ */
+struct rt_mutex
+{
+    pthread_mutex_t mtx;
+    rt_uint8_t dynamic;
+};
+typedef struct rt_mutex *rt_mutex_t;
+
+struct rt_event
+{
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    rt_uint32_t set;
+    rt_uint8_t dynamic;
+};
+typedef struct rt_event *rt_event_t;
+
+struct rt_thread
+{
+    pthread_t tid;
+    void (*entry)(void *parameter);
+    void *parameter;
+    char name[RT_NAME_MAX];
+};
+typedef struct rt_thread *rt_thread_t;
+
+/* each timer runs on its own thread, the timeout function is called with interrupts disabled like a hard timer */
+struct rt_timer
+{
+    void (*timeout)(void *parameter);
+    void *parameter;
+    rt_tick_t init_tick;
+    rt_uint8_t flag;
+    rt_uint8_t dynamic;
+    volatile rt_uint8_t active;
+    rt_uint64_t timeout_ns;
+    pthread_t tid;
+    pthread_cond_t cond;
+};
+typedef struct rt_timer *rt_timer_t;
+
+/* 
+ * device
+ */
+enum rt_device_class_type
+{
+    RT_Device_Class_Char = 0,
+    RT_Device_Class_Block,
+    RT_Device_Class_NetIf,
+    RT_Device_Class_MTD,
+    RT_Device_Class_Miscellaneous,
+    RT_Device_Class_Pin,
+    RT_Device_Class_Unknown
+};
+
+#define RT_DEVICE_FLAG_DEACTIVATE       0x000
+#define RT_DEVICE_FLAG_RDONLY           0x001
+#define RT_DEVICE_FLAG_WRONLY           0x002
+#define RT_DEVICE_FLAG_RDWR             0x003
+#define RT_DEVICE_FLAG_REMOVABLE        0x004
+#define RT_DEVICE_FLAG_STANDALONE       0x008
+#define RT_DEVICE_FLAG_ACTIVATED        0x010
+#define RT_DEVICE_FLAG_SUSPENDED        0x020
+#define RT_DEVICE_FLAG_STREAM           0x040
+#define RT_DEVICE_FLAG_INT_RX           0x100
+#define RT_DEVICE_FLAG_DMA_RX           0x200
+#define RT_DEVICE_FLAG_INT_TX           0x400
+#define RT_DEVICE_FLAG_DMA_TX           0x800
+
+#define RT_DEVICE_OFLAG_CLOSE           0x000
+#define RT_DEVICE_OFLAG_RDONLY          0x001
+#define RT_DEVICE_OFLAG_WRONLY          0x002
+#define RT_DEVICE_OFLAG_RDWR            0x003
+#define RT_DEVICE_OFLAG_OPEN            0x008
+#define RT_DEVICE_OFLAG_MASK            0xf0f
+
+#define RT_DEVICE_CTRL_RESUME           0x01
+#define RT_DEVICE_CTRL_SUSPEND          0x02
+#define RT_DEVICE_CTRL_CONFIG           0x03
+#define RT_DEVICE_CTRL_CLOSE            0x04
+
+typedef struct rt_device *rt_device_t;
+
+struct rt_device
+{
+    char name[RT_NAME_MAX];
+    enum rt_device_class_type type;
+    rt_uint16_t flag;
+    rt_uint16_t open_flag;
+    rt_uint8_t ref_count;
+
+    rt_err_t (*rx_indicate)(rt_device_t dev, rt_size_t size);
+    rt_err_t (*tx_complete)(rt_device_t dev, void *buffer);
+
+    rt_err_t  (*init)   (rt_device_t dev);
+    rt_err_t  (*open)   (rt_device_t dev, rt_uint16_t oflag);
+    rt_err_t  (*close)  (rt_device_t dev);
+    rt_size_t (*read)   (rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+    rt_size_t (*write)  (rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+    rt_err_t  (*control)(rt_device_t dev, int cmd, void *args);
+
+    void *user_data;
+    rt_device_t next;
+};
+
+/* 
+ * clock & thread
+ */
+rt_tick_t rt_tick_get(void);
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms);
+rt_err_t rt_thread_init(struct rt_thread *thread, const char *name, void (*entry)(void *parameter), void *parameter,
+                        void *stack_start, rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick);
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick);
+rt_err_t rt_thread_startup(rt_thread_t thread);
+rt_err_t rt_thread_delay(rt_tick_t tick);
+rt_err_t rt_thread_mdelay(rt_int32_t ms);
+
+void rt_timer_init(rt_timer_t timer, const char *name, void (*timeout)(void *parameter),
+                   void *parameter, rt_tick_t time, rt_uint8_t flag);
+rt_err_t rt_timer_detach(rt_timer_t timer);
+rt_timer_t rt_timer_create(const char *name, void (*timeout)(void *parameter),
+                           void *parameter, rt_tick_t time, rt_uint8_t flag);
+rt_err_t rt_timer_delete(rt_timer_t timer);
+rt_err_t rt_timer_start(rt_timer_t timer);
+rt_err_t rt_timer_stop(rt_timer_t timer);
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg);
+
+/* 
+ * ipc
+ */
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag);
+rt_err_t rt_mutex_detach(rt_mutex_t mutex);
+rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag);
+rt_err_t rt_mutex_delete(rt_mutex_t mutex);
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout);
+rt_err_t rt_mutex_release(rt_mutex_t mutex);
+
+rt_err_t rt_event_init(rt_event_t event, const char *name, rt_uint8_t flag);
+rt_err_t rt_event_detach(rt_event_t event);
+rt_event_t rt_event_create(const char *name, rt_uint8_t flag);
+rt_err_t rt_event_delete(rt_event_t event);
+rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set);
+rt_err_t rt_event_recv(rt_event_t event, rt_uint32_t set, rt_uint8_t opt, rt_int32_t timeout, rt_uint32_t *recved);
+rt_err_t rt_event_control(rt_event_t event, int cmd, void *arg);
+
+/* 
+ * device
+ */
+rt_err_t rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags);
+rt_device_t rt_device_find(const char *name);
+rt_err_t rt_device_open(rt_device_t dev, rt_uint16_t oflag);
+rt_err_t rt_device_close(rt_device_t dev);
+rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+rt_err_t rt_device_control(rt_device_t dev, int cmd, void *arg);
+
+/* 
+ * kernel service
+ */
+#define rt_kprintf              printf
+#define rt_snprintf             snprintf
+#define rt_memset               memset
+#define rt_memcpy               memcpy
+#define rt_memmove              memmove
+#define rt_memcmp               memcmp
+#define rt_strlen               strlen
+#define rt_strncpy              strncpy
+#define rt_strcmp               strcmp
+#define rt_malloc               malloc
+#define rt_calloc               calloc
+#define rt_realloc              realloc
+#define rt_free                 free
+
+#ifdef __cplusplus
+}
+#endif
+#endif
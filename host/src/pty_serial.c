@@ -0,0 +1,598 @@
+/*
+ * pty_serial.c
+ *
+ * host serial device backed by a pseudo terminal pair, behaves like a v1 serial
+ * device: a receive thread plays the rx interrupt, fills the receive fifo and calls
+ * rx_indicate, rt_device_write blocks until the datas are on the wire.
+ * opened with RT_DEVICE_FLAG_INT_RX it indicates every received chunk, opened with
+ * RT_DEVICE_FLAG_DMA_RX it indicates at idle line (one character time without datas)
+ * or when the fifo gets half full, like the dma receive of serial v1.
+ * opened with RT_DEVICE_FLAG_DMA_TX, rt_device_write queues the buffer and returns, a
+ * transmit thread plays the dma and calls tx_complete when the dma has moved the last
+ * byte into the shift register, one character time before it leaves the wire.
+ * the control command RS485_CTRL_HW_DE is acknowledged like a uart driving the transceiver
+ * enable itself, the start bit of a transmit from idle line waits the assertion time.
+ * with RT_USING_SERIAL_V2, opened with RT_DEVICE_FLAG_RX_BLOCKING, rt_device_read waits until
+ * the datas asked are received or the timeout set by RT_SERIAL_CTRL_SET_RX_TIMEOUT elapses, like
+ * the blocking read of serial v2.
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       add dma transmit
+ * 2026-10-17     qiyongzhong       add hardware direction control
+ * 2026-10-17     qiyongzhong       add blocking read of serial v2
+ */
+
+#define _GNU_SOURCE
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <rthw.h>
+#include <pty_serial.h>
+#include <rs485.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PTY_RX_CHUNK    256
+#define PTY_TX_QUEUE    8
+
+struct pty_tx_item
+{
+    const void *buf;
+    rt_size_t size;
+};
+
+struct pty_serial
+{
+    struct rt_device parent;
+    struct serial_configure config;
+    int fd;                         //device side of the pty
+    int peer_fd;                    //far end side of the pty
+    pthread_t rx_tid;               //receive thread, plays the rx interrupt
+    volatile int opened;            //opened flag
+    volatile int dma_rx;            //opened with dma receive
+    volatile int dma_tx;            //opened with dma transmit
+    pthread_t tx_tid;               //transmit thread, plays the tx dma
+    pthread_mutex_t tx_mtx;         //protect the transmit queue
+    pthread_cond_t tx_cond;         //signal of the transmit queue
+    rt_size_t tx_put;               //transmit queue put count
+    rt_size_t tx_get;               //transmit queue get count
+    struct pty_tx_item tx_queue[PTY_TX_QUEUE];
+    rt_uint64_t tx_free_ns;         //time the device side line gets idle
+    rt_uint64_t peer_free_ns;       //time the far end side line gets idle
+    volatile int hw_de_cap;         //supports hardware direction control
+    volatile int hw_de;             //the uart drives transceiver enable
+    rt_uint64_t de_pre_ns;          //transceiver enable assertion time
+    volatile rt_uint64_t rx_ns;     //time the last datas entered the receive fifo
+#ifdef RT_USING_SERIAL_V2
+    volatile int rx_blocking;       //opened with blocking receive of serial v2
+    rt_int32_t rx_timeout;          //receive timeout of blocking read, ticks
+    pthread_mutex_t rx_mtx;         //protect the wait of blocking read
+    pthread_cond_t rx_cond;         //signal of datas entered the receive fifo
+#endif
+    rt_size_t put_index;            //receive fifo put index
+    rt_size_t get_index;            //receive fifo get index
+    rt_uint8_t rx_fifo[RT_SERIAL_RB_BUFSZ];
+};
+
+static rt_uint64_t pty_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((rt_uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+static void pty_sleep_until(rt_uint64_t ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ull;
+    ts.tv_nsec = ns % 1000000000ull;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, RT_NULL) == EINTR);
+}
+
+static rt_uint64_t pty_wire_ns(struct pty_serial *pty, rt_size_t size)
+{
+    rt_uint32_t bits = 1 + pty->config.data_bits + (pty->config.parity != PARITY_NONE) + 
+                        (pty->config.stop_bits == STOP_BITS_2 ? 2 : 1);
+    return((rt_uint64_t)size * bits * 1000000000ull / pty->config.baud_rate);
+}
+
+/* occupy the line for the wire time, return the time the last stop bit leaves the wire */
+static rt_uint64_t pty_wire_reserve(struct pty_serial *pty, rt_uint64_t *line_free, rt_size_t size)
+{
+    rt_uint64_t start = pty_now_ns();
+    
+    if (start < *line_free)
+    {
+        start = *line_free;
+    }
+    else if ((line_free == &pty->tx_free_ns) && pty->hw_de)//transceiver enable is asserted before the start bit
+    {
+        start += pty->de_pre_ns;
+    }
+    *line_free = start + pty_wire_ns(pty, size);
+    return(*line_free);
+}
+
+static int pty_fd_write(int fd, const void *buf, rt_size_t size)
+{
+    const rt_uint8_t *p = buf;
+    rt_size_t left = size;
+
+    while (left)
+    {
+        ssize_t len = write(fd, p, left);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return(-RT_EIO);
+        }
+        p += len;
+        left -= len;
+    }
+    return((int)size);
+}
+
+/* occupy the line for the wire time, then hand the datas to the other side */
+static int pty_wire_write(struct pty_serial *pty, int fd, rt_uint64_t *line_free, const void *buf, rt_size_t size)
+{
+    pty_sleep_until(pty_wire_reserve(pty, line_free, size));
+    return(pty_fd_write(fd, buf, size));
+}
+
+static void *pty_tx_entry(void *arg)
+{
+    struct pty_serial *pty = arg;
+    
+    while (1)
+    {
+        struct pty_tx_item item;
+        rt_uint64_t end, dma_end;
+        rt_uint8_t *copy;
+        rt_base_t level;
+        
+        pthread_mutex_lock(&pty->tx_mtx);
+        while (pty->tx_get == pty->tx_put)
+        {
+            pthread_cond_wait(&pty->tx_cond, &pty->tx_mtx);
+        }
+        item = pty->tx_queue[pty->tx_get % PTY_TX_QUEUE];
+        pthread_mutex_unlock(&pty->tx_mtx);
+        
+        end = pty_wire_reserve(pty, &pty->tx_free_ns, item.size);
+        dma_end = end - pty_wire_ns(pty, 1);//the last byte is still in the shift register
+        pty_sleep_until(dma_end);
+        copy = rt_malloc(item.size);//the buffer belongs to the caller again after tx_complete
+        if (copy)
+        {
+            rt_memcpy(copy, item.buf, item.size);
+        }
+        
+        pthread_mutex_lock(&pty->tx_mtx);
+        pty->tx_get++;
+        pthread_cond_broadcast(&pty->tx_cond);
+        pthread_mutex_unlock(&pty->tx_mtx);
+        
+        level = rt_hw_interrupt_disable();
+        if (pty->parent.tx_complete)
+        {
+            pty->parent.tx_complete(&pty->parent, (void *)item.buf);
+        }
+        rt_hw_interrupt_enable(level);
+        
+        pty_sleep_until(end);
+        if (copy)
+        {
+            pty_fd_write(pty->fd, copy, item.size);
+            rt_free(copy);
+        }
+    }
+    return(RT_NULL);
+}
+
+static void pty_rx_indicate(struct pty_serial *pty)
+{
+    rt_size_t count = (pty->put_index + RT_SERIAL_RB_BUFSZ - pty->get_index) % RT_SERIAL_RB_BUFSZ;
+    pty->rx_ns = pty_now_ns();
+    if (pty->parent.rx_indicate)
+    {
+        pty->parent.rx_indicate(&pty->parent, count);
+    }
+}
+
+#ifdef RT_USING_SERIAL_V2
+static rt_size_t pty_rx_count(struct pty_serial *pty)
+{
+    return((pty->put_index + RT_SERIAL_RB_BUFSZ - pty->get_index) % RT_SERIAL_RB_BUFSZ);
+}
+
+/* blocking read of serial v2 waits the datas asked up to the receive timeout */
+static void pty_rx_wait(struct pty_serial *pty, rt_size_t size)
+{
+    rt_uint64_t end = pty_now_ns() + (rt_uint64_t)pty->rx_timeout * 1000000000ull / RT_TICK_PER_SECOND;
+    struct timespec ts;
+    
+    ts.tv_sec = end / 1000000000ull;
+    ts.tv_nsec = end % 1000000000ull;
+    pthread_mutex_lock(&pty->rx_mtx);
+    while (pty_rx_count(pty) < size)
+    {
+        if (pty->rx_timeout < 0)
+        {
+            pthread_cond_wait(&pty->rx_cond, &pty->rx_mtx);
+        }
+        else if (pthread_cond_timedwait(&pty->rx_cond, &pty->rx_mtx, &ts) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pty->rx_mtx);
+}
+#endif
+
+static void *pty_rx_entry(void *arg)
+{
+    struct pty_serial *pty = arg;
+    rt_uint8_t chunk[PTY_RX_CHUNK];
+    struct pollfd pfd;
+    struct timespec ts;
+    int pending = 0;
+
+    pfd.fd = pty->fd;
+    pfd.events = POLLIN;
+    while (1)
+    {
+        ssize_t len;
+        rt_size_t count;
+        rt_base_t level;
+        rt_uint64_t tmo = pending ? pty_wire_ns(pty, 1) : 100000000ull;
+
+        ts.tv_sec = tmo / 1000000000ull;
+        ts.tv_nsec = tmo % 1000000000ull;
+        if (ppoll(&pfd, 1, &ts, RT_NULL) <= 0)
+        {
+            if (pending)//idle line
+            {
+                pending = 0;
+                level = rt_hw_interrupt_disable();
+                pty_rx_indicate(pty);
+                rt_hw_interrupt_enable(level);
+            }
+            continue;
+        }
+        len = read(pty->fd, chunk, sizeof(chunk));
+        if (len <= 0 || ! pty->opened)
+        {
+            continue;
+        }
+
+        level = rt_hw_interrupt_disable();
+        for (ssize_t i = 0; i < len; i++)
+        {
+            pty->rx_fifo[pty->put_index] = chunk[i];
+            pty->put_index = (pty->put_index + 1) % RT_SERIAL_RB_BUFSZ;
+            if (pty->put_index == pty->get_index)//fifo full, drop the oldest byte like serial v1
+            {
+                pty->get_index = (pty->get_index + 1) % RT_SERIAL_RB_BUFSZ;
+            }
+        }
+        count = (pty->put_index + RT_SERIAL_RB_BUFSZ - pty->get_index) % RT_SERIAL_RB_BUFSZ;
+        if ( ! pty->dma_rx || count >= RT_SERIAL_RB_BUFSZ / 2)
+        {
+            pending = 0;
+            pty_rx_indicate(pty);
+        }
+        else
+        {
+            pending = 1;
+        }
+        rt_hw_interrupt_enable(level);
+#ifdef RT_USING_SERIAL_V2
+        pthread_mutex_lock(&pty->rx_mtx);
+        pthread_cond_broadcast(&pty->rx_cond);
+        pthread_mutex_unlock(&pty->rx_mtx);
+#endif
+    }
+    return(RT_NULL);
+}
+
+static rt_err_t pty_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    struct pty_serial *pty = (struct pty_serial *)dev;
+    rt_base_t level = rt_hw_interrupt_disable();
+    pty->put_index = 0;
+    pty->get_index = 0;
+    pty->dma_rx = ((oflag & RT_DEVICE_FLAG_DMA_RX) != 0);
+    pty->dma_tx = ((oflag & RT_DEVICE_FLAG_DMA_TX) != 0);
+#ifdef RT_USING_SERIAL_V2
+    pty->rx_blocking = ((oflag & RT_DEVICE_FLAG_RX_BLOCKING) != 0);
+    pty->rx_timeout = RT_WAITING_FOREVER;
+#endif
+    pty->opened = 1;
+    rt_hw_interrupt_enable(level);
+    return(RT_EOK);
+}
+
+static rt_err_t pty_close(rt_device_t dev)
+{
+    struct pty_serial *pty = (struct pty_serial *)dev;
+    pty->opened = 0;
+    return(RT_EOK);
+}
+
+static rt_size_t pty_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    struct pty_serial *pty = (struct pty_serial *)dev;
+    rt_uint8_t *p = buffer;
+    rt_size_t len = 0;
+    rt_base_t level;
+    
+#ifdef RT_USING_SERIAL_V2
+    if (pty->rx_blocking && pty->rx_timeout != 0)
+    {
+        pty_rx_wait(pty, size);
+    }
+#endif
+    level = rt_hw_interrupt_disable();
+    
+    while (len < size && pty->get_index != pty->put_index)
+    {
+        p[len++] = pty->rx_fifo[pty->get_index];
+        pty->get_index = (pty->get_index + 1) % RT_SERIAL_RB_BUFSZ;
+    }
+    rt_hw_interrupt_enable(level);
+    
+    return(len);
+}
+
+static rt_size_t pty_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    struct pty_serial *pty = (struct pty_serial *)dev;
+    int len;
+    
+    if (pty->dma_tx)//queue the buffer like the data queue of serial v1 dma transmit
+    {
+        pthread_mutex_lock(&pty->tx_mtx);
+        while (pty->tx_put - pty->tx_get >= PTY_TX_QUEUE)
+        {
+            pthread_cond_wait(&pty->tx_cond, &pty->tx_mtx);
+        }
+        pty->tx_queue[pty->tx_put % PTY_TX_QUEUE].buf = buffer;
+        pty->tx_queue[pty->tx_put % PTY_TX_QUEUE].size = size;
+        pty->tx_put++;
+        pthread_cond_broadcast(&pty->tx_cond);
+        pthread_mutex_unlock(&pty->tx_mtx);
+        return(size);
+    }
+    
+    len = pty_wire_write(pty, pty->fd, &pty->tx_free_ns, buffer, size);
+    return(len < 0 ? 0 : len);
+}
+
+static rt_err_t pty_control(rt_device_t dev, int cmd, void *args)
+{
+    struct pty_serial *pty = (struct pty_serial *)dev;
+    
+    switch (cmd)
+    {
+    case RT_DEVICE_CTRL_CONFIG:
+        if (args == RT_NULL)
+        {
+            return(-RT_EINVAL);
+        }
+        pty->config = *(struct serial_configure *)args;
+        if (pty->config.baud_rate == 0)
+        {
+            return(-RT_EINVAL);
+        }
+        return(RT_EOK);
+    case RS485_CTRL_HW_DE:
+        if (args == RT_NULL)
+        {
+            return(-RT_EINVAL);
+        }
+        if ( ! pty->hw_de_cap)//like a driver without the command, unknown commands return RT_EOK
+        {
+            return(RT_EOK);
+        }
+        pty->de_pre_ns = (rt_uint64_t)((struct rs485_hw_de *)args)->pre_us * 1000;
+        pty->hw_de = ((struct rs485_hw_de *)args)->enable;
+        ((struct rs485_hw_de *)args)->ack = 1;
+        return(RT_EOK);
+#ifdef RT_USING_SERIAL_V2
+    case RT_SERIAL_CTRL_SET_RX_TIMEOUT:
+        if (args == RT_NULL)
+        {
+            return(-RT_EINVAL);
+        }
+        pty->rx_timeout = *(rt_int32_t *)args;
+        return(RT_EOK);
+#endif
+    default:
+        break;
+    }
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   create a pty backed serial device and register it
+ * @param   name        - device name
+ * @retval  device handle, NULL - error
+ */
+rt_device_t pty_serial_create(const char *name)
+{
+    struct serial_configure config = RT_SERIAL_CONFIG_DEFAULT;
+    struct pty_serial *pty;
+    struct termios tio;
+    
+    pty = rt_calloc(1, sizeof(struct pty_serial));
+    if (pty == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+
+    pty->peer_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty->peer_fd < 0 || grantpt(pty->peer_fd) != 0 || unlockpt(pty->peer_fd) != 0)
+    {
+        goto _fail;
+    }
+    pty->fd = open(ptsname(pty->peer_fd), O_RDWR | O_NOCTTY);
+    if (pty->fd < 0)
+    {
+        goto _fail;
+    }
+    tcgetattr(pty->fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(pty->fd, TCSANOW, &tio);
+
+    pty->config = config;
+    pty->hw_de_cap = 1;
+    pty->parent.type = RT_Device_Class_Char;
+    pty->parent.open = pty_open;
+    pty->parent.close = pty_close;
+    pty->parent.read = pty_read;
+    pty->parent.write = pty_write;
+    pty->parent.control = pty_control;
+    if (rt_device_register(&pty->parent, name, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_INT_RX | RT_DEVICE_FLAG_DMA_RX | RT_DEVICE_FLAG_DMA_TX) != RT_EOK)
+    {
+        goto _fail;
+    }
+    
+#ifdef RT_USING_SERIAL_V2
+    {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_mutex_init(&pty->rx_mtx, RT_NULL);
+        pthread_cond_init(&pty->rx_cond, &attr);
+        pthread_condattr_destroy(&attr);
+    }
+#endif
+    if (pthread_create(&pty->rx_tid, RT_NULL, pty_rx_entry, pty) != 0)
+    {
+        goto _fail;
+    }
+    pthread_mutex_init(&pty->tx_mtx, RT_NULL);
+    pthread_cond_init(&pty->tx_cond, RT_NULL);
+    if (pthread_create(&pty->tx_tid, RT_NULL, pty_tx_entry, pty) != 0)
+    {
+        goto _fail;
+    }
+    
+    return(&pty->parent);
+
+_fail:
+    if (pty->fd > 0)
+    {
+        close(pty->fd);
+    }
+    if (pty->peer_fd >= 0)
+    {
+        close(pty->peer_fd);
+    }
+    rt_free(pty);
+    return(RT_NULL);
+}
+
+/* 
+ * @brief   get wire time of datas at current serial config
+ * @param   dev         - device handle
+ * @param   size        - length of datas
+ * @retval  wire time, us
+ */
+rt_uint32_t pty_serial_wire_us(rt_device_t dev, rt_size_t size)
+{
+    return((rt_uint32_t)(pty_wire_ns((struct pty_serial *)dev, size) / 1000));
+}
+
+/* 
+ * @brief   set whether the device supports hardware direction control, it does after created
+ * @param   dev         - device handle
+ * @param   cap         - 0--no support, 1--support
+ */
+void pty_serial_set_hw_de_cap(rt_device_t dev, int cap)
+{
+    ((struct pty_serial *)dev)->hw_de_cap = cap;
+}
+
+/* 
+ * @brief   get whether the uart drives transceiver enable
+ * @param   dev         - device handle
+ * @retval  0--no, 1--yes
+ */
+int pty_serial_hw_de(rt_device_t dev)
+{
+    return(((struct pty_serial *)dev)->hw_de);
+}
+
+/* 
+ * @brief   send datas from the far end node, blocks for the wire time
+ * @param   dev         - device handle
+ * @param   buf         - datas addr
+ * @param   size        - length of datas
+ * @retval  >=0 - length of sent datas, <0 - error
+ */
+int pty_serial_peer_send(rt_device_t dev, const void *buf, int size)
+{
+    struct pty_serial *pty = (struct pty_serial *)dev;
+    return(pty_wire_write(pty, pty->peer_fd, &pty->peer_free_ns, buf, size));
+}
+
+/* 
+ * @brief   receive datas at the far end node
+ * @param   dev         - device handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @param   tmo_ms      - wait timeout, <0 - wait forever
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int pty_serial_peer_recv(rt_device_t dev, void *buf, int size, int tmo_ms)
+{
+    struct pty_serial *pty = (struct pty_serial *)dev;
+    struct pollfd pfd;
+    ssize_t len;
+
+    pfd.fd = pty->peer_fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, tmo_ms) <= 0)
+    {
+        return(0);
+    }
+    len = read(pty->peer_fd, buf, size);
+    return(len < 0 ? -RT_EIO : (int)len);
+}
+
+/* 
+ * @brief   get the time the last datas entered the receive fifo of device side
+ * @param   dev         - device handle
+ * @retval  microseconds of host monotonic clock
+ */
+rt_uint64_t pty_serial_last_rx_us(rt_device_t dev)
+{
+    return(((struct pty_serial *)dev)->rx_ns / 1000);
+}
+
+/* 
+ * @brief   get microseconds of host monotonic clock
+ * @retval  microseconds
+ */
+rt_uint64_t pty_serial_now_us(void)
+{
+    return(pty_now_ns() / 1000);
+}
+
+/* 
+ * @brief   microsecond clock of the board, overrides the tick based default of rs485 package
+ * @retval  microseconds
+ */
+rt_uint32_t rs485_get_us(void)
+{
+    return((rt_uint32_t)(pty_now_ns() / 1000));
+}
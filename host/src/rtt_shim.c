@@ -0,0 +1,566 @@
+/*
+ * rtt_shim.c
+ *
+ * host shim of the rt-thread kernel api used by rs485 package
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       add timer
+ * 2026-10-17     qiyongzhong       add static thread
+ */
+
+#define _GNU_SOURCE
+#include <rtthread.h>
+#include <rtdevice.h>
+#include <rthw.h>
+#include <errno.h>
+#include <time.h>
+
+static pthread_mutex_t irq_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t dev_lock = PTHREAD_MUTEX_INITIALIZER;
+static rt_device_t dev_list = RT_NULL;
+
+static rt_uint64_t shim_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((rt_uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+static void shim_abs_time(struct timespec *ts, rt_int32_t tick)
+{
+    rt_uint64_t ns = shim_now_ns() + (rt_uint64_t)tick * (1000000000ull / RT_TICK_PER_SECOND);
+    ts->tv_sec = ns / 1000000000ull;
+    ts->tv_nsec = ns % 1000000000ull;
+}
+
+/* 
+ * cpu port
+ */
+rt_base_t rt_hw_interrupt_disable(void)
+{
+    pthread_mutex_lock(&irq_lock);
+    return(0);
+}
+
+void rt_hw_interrupt_enable(rt_base_t level)
+{
+    pthread_mutex_unlock(&irq_lock);
+}
+
+void rt_hw_us_delay(rt_uint32_t us)
+{
+    rt_uint64_t end = shim_now_ns() + (rt_uint64_t)us * 1000;
+    while (shim_now_ns() < end);
+}
+
+/* 
+ * clock & thread
+ */
+rt_tick_t rt_tick_get(void)
+{
+    return((rt_tick_t)(shim_now_ns() / (1000000000ull / RT_TICK_PER_SECOND)));
+}
+
+rt_tick_t rt_tick_from_millisecond(rt_int32_t ms)
+{
+    if (ms < 0)
+    {
+        return((rt_tick_t)RT_WAITING_FOREVER);
+    }
+    return((rt_tick_t)((rt_int64_t)ms * RT_TICK_PER_SECOND / 1000));
+}
+
+static void *shim_thread_entry(void *arg)
+{
+    rt_thread_t thread = (rt_thread_t)arg;
+    thread->entry(thread->parameter);
+    return(RT_NULL);
+}
+
+rt_err_t rt_thread_init(struct rt_thread *thread, const char *name, void (*entry)(void *parameter), void *parameter,
+                        void *stack_start, rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick)
+{
+    memset(thread, 0, sizeof(struct rt_thread));
+    strncpy(thread->name, name, RT_NAME_MAX - 1);
+    thread->entry = entry;
+    thread->parameter = parameter;
+    return(RT_EOK);
+}
+
+rt_thread_t rt_thread_create(const char *name, void (*entry)(void *parameter), void *parameter,
+                             rt_uint32_t stack_size, rt_uint8_t priority, rt_uint32_t tick)
+{
+    rt_thread_t thread = rt_calloc(1, sizeof(struct rt_thread));
+    if (thread == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+    rt_thread_init(thread, name, entry, parameter, RT_NULL, stack_size, priority, tick);
+    return(thread);
+}
+
+rt_err_t rt_thread_startup(rt_thread_t thread)
+{
+    if (pthread_create(&thread->tid, RT_NULL, shim_thread_entry, thread) != 0)
+    {
+        return(-RT_ERROR);
+    }
+    pthread_detach(thread->tid);
+    return(RT_EOK);
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+    struct timespec ts;
+    shim_abs_time(&ts, tick);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, RT_NULL) == EINTR);
+    return(RT_EOK);
+}
+
+rt_err_t rt_thread_mdelay(rt_int32_t ms)
+{
+    return(rt_thread_delay(rt_tick_from_millisecond(ms)));
+}
+
+/* 
+ * timer, one thread per timer
+ */
+static void shim_timer_unlock(void *arg)
+{
+    pthread_mutex_unlock(&timer_lock);
+}
+
+static void *shim_timer_entry(void *arg)
+{
+    rt_timer_t timer = (rt_timer_t)arg;
+    
+    pthread_mutex_lock(&timer_lock);
+    pthread_cleanup_push(shim_timer_unlock, RT_NULL);//detach cancels the thread in the waits
+    while (1)
+    {
+        struct timespec ts;
+        
+        if ( ! timer->active)
+        {
+            pthread_cond_wait(&timer->cond, &timer_lock);
+            continue;
+        }
+        ts.tv_sec = timer->timeout_ns / 1000000000ull;
+        ts.tv_nsec = timer->timeout_ns % 1000000000ull;
+        if (pthread_cond_timedwait(&timer->cond, &timer_lock, &ts) != ETIMEDOUT || ! timer->active)
+        {
+            continue;
+        }
+        if (timer->flag & RT_TIMER_FLAG_PERIODIC)
+        {
+            timer->timeout_ns += (rt_uint64_t)timer->init_tick * (1000000000ull / RT_TICK_PER_SECOND);
+        }
+        else
+        {
+            timer->active = 0;
+        }
+        pthread_mutex_unlock(&timer_lock);
+        
+        rt_hw_interrupt_disable();
+        timer->timeout(timer->parameter);
+        rt_hw_interrupt_enable(0);
+        
+        pthread_mutex_lock(&timer_lock);
+    }
+    pthread_cleanup_pop(1);
+    return(RT_NULL);
+}
+
+void rt_timer_init(rt_timer_t timer, const char *name, void (*timeout)(void *parameter),
+                   void *parameter, rt_tick_t time, rt_uint8_t flag)
+{
+    pthread_condattr_t attr;
+    
+    timer->timeout = timeout;
+    timer->parameter = parameter;
+    timer->init_tick = time;
+    timer->flag = flag;
+    timer->dynamic = 0;
+    timer->active = 0;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_create(&timer->tid, RT_NULL, shim_timer_entry, timer);
+}
+
+rt_err_t rt_timer_detach(rt_timer_t timer)
+{
+    rt_timer_stop(timer);
+    pthread_cancel(timer->tid);
+    pthread_join(timer->tid, RT_NULL);
+    pthread_cond_destroy(&timer->cond);
+    return(RT_EOK);
+}
+
+rt_timer_t rt_timer_create(const char *name, void (*timeout)(void *parameter),
+                           void *parameter, rt_tick_t time, rt_uint8_t flag)
+{
+    rt_timer_t timer = rt_malloc(sizeof(struct rt_timer));
+    if (timer == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+    rt_timer_init(timer, name, timeout, parameter, time, flag);
+    timer->dynamic = 1;
+    return(timer);
+}
+
+rt_err_t rt_timer_delete(rt_timer_t timer)
+{
+    rt_timer_detach(timer);
+    rt_free(timer);
+    return(RT_EOK);
+}
+
+rt_err_t rt_timer_start(rt_timer_t timer)
+{
+    pthread_mutex_lock(&timer_lock);
+    timer->timeout_ns = shim_now_ns() + (rt_uint64_t)timer->init_tick * (1000000000ull / RT_TICK_PER_SECOND);
+    timer->active = 1;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer_lock);
+    return(RT_EOK);
+}
+
+rt_err_t rt_timer_stop(rt_timer_t timer)
+{
+    pthread_mutex_lock(&timer_lock);
+    if ( ! timer->active)
+    {
+        pthread_mutex_unlock(&timer_lock);
+        return(-RT_ERROR);
+    }
+    timer->active = 0;
+    pthread_cond_signal(&timer->cond);
+    pthread_mutex_unlock(&timer_lock);
+    return(RT_EOK);
+}
+
+rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg)
+{
+    pthread_mutex_lock(&timer_lock);
+    switch (cmd)
+    {
+    case RT_TIMER_CTRL_SET_TIME:
+        timer->init_tick = *(rt_tick_t *)arg;
+        break;
+    case RT_TIMER_CTRL_GET_TIME:
+        *(rt_tick_t *)arg = timer->init_tick;
+        break;
+    default:
+        break;
+    }
+    pthread_mutex_unlock(&timer_lock);
+    return(RT_EOK);
+}
+
+/* 
+ * mutex, recursive like rt-thread mutex
+ */
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex->mtx, &attr);
+    pthread_mutexattr_destroy(&attr);
+    mutex->dynamic = 0;
+    return(RT_EOK);
+}
+
+rt_err_t rt_mutex_detach(rt_mutex_t mutex)
+{
+    pthread_mutex_destroy(&mutex->mtx);
+    return(RT_EOK);
+}
+
+rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag)
+{
+    rt_mutex_t mutex = rt_malloc(sizeof(struct rt_mutex));
+    if (mutex == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+    rt_mutex_init(mutex, name, flag);
+    mutex->dynamic = 1;
+    return(mutex);
+}
+
+rt_err_t rt_mutex_delete(rt_mutex_t mutex)
+{
+    rt_mutex_detach(mutex);
+    rt_free(mutex);
+    return(RT_EOK);
+}
+
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t timeout)
+{
+    struct timespec ts;
+    
+    if (timeout < 0)
+    {
+        return(pthread_mutex_lock(&mutex->mtx) == 0 ? RT_EOK : -RT_ERROR);
+    }
+    if (timeout == 0)
+    {
+        return(pthread_mutex_trylock(&mutex->mtx) == 0 ? RT_EOK : -RT_ETIMEOUT);
+    }
+    shim_abs_time(&ts, timeout);
+    return(pthread_mutex_clocklock(&mutex->mtx, CLOCK_MONOTONIC, &ts) == 0 ? RT_EOK : -RT_ETIMEOUT);
+}
+
+rt_err_t rt_mutex_release(rt_mutex_t mutex)
+{
+    return(pthread_mutex_unlock(&mutex->mtx) == 0 ? RT_EOK : -RT_ERROR);
+}
+
+/* 
+ * event
+ */
+rt_err_t rt_event_init(rt_event_t event, const char *name, rt_uint8_t flag)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&event->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&event->mtx, RT_NULL);
+    event->set = 0;
+    event->dynamic = 0;
+    return(RT_EOK);
+}
+
+rt_err_t rt_event_detach(rt_event_t event)
+{
+    pthread_cond_destroy(&event->cond);
+    pthread_mutex_destroy(&event->mtx);
+    return(RT_EOK);
+}
+
+rt_event_t rt_event_create(const char *name, rt_uint8_t flag)
+{
+    rt_event_t event = rt_malloc(sizeof(struct rt_event));
+    if (event == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+    rt_event_init(event, name, flag);
+    event->dynamic = 1;
+    return(event);
+}
+
+rt_err_t rt_event_delete(rt_event_t event)
+{
+    rt_event_detach(event);
+    rt_free(event);
+    return(RT_EOK);
+}
+
+rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set)
+{
+    pthread_mutex_lock(&event->mtx);
+    event->set |= set;
+    pthread_cond_broadcast(&event->cond);
+    pthread_mutex_unlock(&event->mtx);
+    return(RT_EOK);
+}
+
+static int shim_event_match(rt_event_t event, rt_uint32_t set, rt_uint8_t opt)
+{
+    if (opt & RT_EVENT_FLAG_AND)
+    {
+        return((event->set & set) == set);
+    }
+    return((event->set & set) != 0);
+}
+
+rt_err_t rt_event_recv(rt_event_t event, rt_uint32_t set, rt_uint8_t opt, rt_int32_t timeout, rt_uint32_t *recved)
+{
+    struct timespec ts;
+    rt_err_t result = RT_EOK;
+
+    if (timeout > 0)
+    {
+        shim_abs_time(&ts, timeout);
+    }
+    
+    pthread_mutex_lock(&event->mtx);
+    while ( ! shim_event_match(event, set, opt))
+    {
+        if (timeout == 0)
+        {
+            result = -RT_ETIMEOUT;
+            break;
+        }
+        if (timeout < 0)
+        {
+            pthread_cond_wait(&event->cond, &event->mtx);
+        }
+        else if (pthread_cond_timedwait(&event->cond, &event->mtx, &ts) == ETIMEDOUT)
+        {
+            if ( ! shim_event_match(event, set, opt))
+            {
+                result = -RT_ETIMEOUT;
+            }
+            break;
+        }
+    }
+    if (result == RT_EOK)
+    {
+        if (recved)
+        {
+            *recved = (event->set & set);
+        }
+        if (opt & RT_EVENT_FLAG_CLEAR)
+        {
+            event->set &= ~set;
+        }
+    }
+    pthread_mutex_unlock(&event->mtx);
+    
+    return(result);
+}
+
+rt_err_t rt_event_control(rt_event_t event, int cmd, void *arg)
+{
+    if (cmd == RT_IPC_CMD_RESET)
+    {
+        pthread_mutex_lock(&event->mtx);
+        event->set = 0;
+        pthread_mutex_unlock(&event->mtx);
+        return(RT_EOK);
+    }
+    return(-RT_ERROR);
+}
+
+/* 
+ * device
+ */
+rt_err_t rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags)
+{
+    if (rt_device_find(name) != RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+    strncpy(dev->name, name, RT_NAME_MAX - 1);
+    dev->flag = flags;
+    dev->ref_count = 0;
+    dev->open_flag = 0;
+    pthread_mutex_lock(&dev_lock);
+    dev->next = dev_list;
+    dev_list = dev;
+    pthread_mutex_unlock(&dev_lock);
+    return(RT_EOK);
+}
+
+rt_device_t rt_device_find(const char *name)
+{
+    rt_device_t dev;
+    pthread_mutex_lock(&dev_lock);
+    for (dev = dev_list; dev != RT_NULL; dev = dev->next)
+    {
+        if (strncmp(dev->name, name, RT_NAME_MAX - 1) == 0)
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&dev_lock);
+    return(dev);
+}
+
+rt_err_t rt_device_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    rt_err_t result = RT_EOK;
+
+    if (dev->ref_count == 0 && dev->open)
+    {
+        result = dev->open(dev, oflag);
+    }
+    if (result == RT_EOK)
+    {
+        dev->open_flag = (oflag & RT_DEVICE_OFLAG_MASK) | RT_DEVICE_OFLAG_OPEN;
+        dev->ref_count++;
+    }
+    return(result);
+}
+
+rt_err_t rt_device_close(rt_device_t dev)
+{
+    if (dev->ref_count == 0)
+    {
+        return(-RT_ERROR);
+    }
+    if (--dev->ref_count == 0)
+    {
+        if (dev->close)
+        {
+            dev->close(dev);
+        }
+        dev->open_flag = RT_DEVICE_OFLAG_CLOSE;
+    }
+    return(RT_EOK);
+}
+
+rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    if (dev->ref_count == 0 || dev->read == RT_NULL)
+    {
+        return(0);
+    }
+    return(dev->read(dev, pos, buffer, size));
+}
+
+rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    if (dev->ref_count == 0 || dev->write == RT_NULL)
+    {
+        return(0);
+    }
+    return(dev->write(dev, pos, buffer, size));
+}
+
+rt_err_t rt_device_control(rt_device_t dev, int cmd, void *arg)
+{
+    if (dev->control == RT_NULL)
+    {
+        return(-RT_ENOSYS);
+    }
+    return(dev->control(dev, cmd, arg));
+}
+
+/* 
+ * pin, only remembers the level so it can be checked
+ */
+#define SHIM_PIN_NUM    256
+
+static rt_uint8_t pin_level[SHIM_PIN_NUM];
+
+void rt_pin_mode(rt_base_t pin, rt_base_t mode)
+{
+}
+
+void rt_pin_write(rt_base_t pin, rt_base_t value)
+{
+    if (pin >= 0 && pin < SHIM_PIN_NUM)
+    {
+        pin_level[pin] = (value != 0);
+    }
+}
+
+int rt_pin_read(rt_base_t pin)
+{
+    if (pin >= 0 && pin < SHIM_PIN_NUM)
+    {
+        return(pin_level[pin]);
+    }
+    return(PIN_LOW);
+}
@@ -6,12 +6,43 @@
  * 2020-06-08     qiyongzhong       first version
  * 2020-12-17     qiyongzhong       add sample
  * 2020-12-18     qiyongzhong       add rs485_send_then_recv
+ * 2026-10-17     qiyongzhong       add microsecond frame gap detection
+ * 2026-10-17     qiyongzhong       add dma receive mode
+ * 2026-10-17     qiyongzhong       add zero copy frame receive
+ * 2026-10-17     qiyongzhong       add frame handler
+ * 2026-10-17     qiyongzhong       separate receive lock from bus lock
+ * 2026-10-17     qiyongzhong       add per instance switch delay from baudrate
+ * 2026-10-17     qiyongzhong       add asynchronous dma transmit
+ * 2026-10-17     qiyongzhong       add scatter gather transmit
+ * 2026-10-17     qiyongzhong       add batched transactions
+ * 2026-10-17     qiyongzhong       add scatter receive transfer, add modbus option
+ * 2026-10-17     qiyongzhong       add modbus slave option
+ * 2026-10-17     qiyongzhong       add running crc of receive
+ * 2026-10-17     qiyongzhong       add receive completed by frame predicate
+ * 2026-10-17     qiyongzhong       add delimiter terminated receive
+ * 2026-10-17     qiyongzhong       add static instance init and detach
+ * 2026-10-17     qiyongzhong       add performance counters
+ * 2026-10-17     qiyongzhong       add traffic trace ring
+ * 2026-10-17     qiyongzhong       add event loop servicing many instances in one thread
+ * 2026-10-17     qiyongzhong       add adaptive per peer response timeout
+ * 2026-10-17     qiyongzhong       add receive ring filled by receive indication
+ * 2026-10-17     qiyongzhong       add cancel and deadline of blocking calls
+ * 2026-10-17     qiyongzhong       add hardware direction control of serial driver
+ * 2026-10-17     qiyongzhong       add serial framework v2 backend
+ * 2026-10-17     qiyongzhong       add microsecond clock option of frame gap
+ * 2026-10-17     qiyongzhong       check frame pool size
+ * 2026-10-17     qiyongzhong       limit predicate to first receive segment
+ * 2026-10-17     qiyongzhong       stamp first receive indication after request
+ * 2026-10-17     qiyongzhong       cancel wait of asynchronous transmit
+ * 2026-10-17     qiyongzhong       add idle line frame end connect flag
+ * 2026-10-17     qiyongzhong       return receive crc from the transaction
  */
 
 #ifndef __DRV_RS485_H__
 #define __DRV_RS485_H__
 
 #include <rtconfig.h>
+#include <rtthread.h>
 #ifdef __cplusplus
 extern "C"
 {
@@ -19,13 +50,335 @@ extern "C"
 //#define RS485_USING_TEST
 //#define RS485_USING_SAMPLE_SLAVE
 //#define RS485_USING_SAMPLE_MASTER
+//#define RS485_USING_DWT_CLOCK   //use cortex-m cycle counter as microsecond clock of frame gap detection
+//#define RS485_USING_US_CLOCK    //board overrides rs485_get_us with a microsecond clock, frame gaps below a tick are detected
+//#define RS485_USING_FRAME_POOL  //preallocate a frame pool in each instance for zero copy frame receive
+//#define RS485_USING_FRAME_HANDLER   //deliver frames to handlers from event loop threads, see rs485_loop_init
+//#define RS485_USING_MODBUS      //modbus rtu master, see rs485_modbus.h
+//#define RS485_USING_MODBUS_SLAVE    //modbus rtu slave, see rs485_modbus.h
+//#define RS485_USING_SCHED       //deadline based master poll scheduler, see rs485_sched.h
+//#define RS485_USING_STATS       //count traffic, errors, lock wait and transaction latency of each instance
+//#define RS485_USING_TRACE       //record sends, receives and timeouts of each instance in a trace ring
+//#define RS485_USING_RX_RING     //receive indication moves datas into a lock free ring of instance, receivers read the ring
+//#define RS485_USING_RTO         //learn response timeout of each peer from its latency, see rs485_send_then_recv_peer
+//#define RS485_USING_HW_DE       //rs485_connect requests hardware direction control of serial driver, see RS485_CONN_HW_DE
+//#define RS485_USING_SERIAL_V2   //serial framework v2 backend, receives wait in blocking timed reads of driver
+
+#ifdef RS485_USING_DWT_CLOCK   //the cycle counter is a microsecond clock
+#ifndef RS485_USING_US_CLOCK
+#define RS485_USING_US_CLOCK
+#endif
+#endif
+
+#ifdef RS485_USING_MODBUS_SLAVE //modbus slave is built on frame handler and modbus crc
+#ifndef RS485_USING_FRAME_HANDLER
+#define RS485_USING_FRAME_HANDLER
+#endif
+#ifndef RS485_USING_MODBUS
+#define RS485_USING_MODBUS
+#endif
+#endif
+
+#ifndef RS485_FRAME_POOL_NUM
+#define RS485_FRAME_POOL_NUM    4       //frames in the pool of each instance, 1~32
+#endif
+
+#if defined(RS485_USING_FRAME_POOL) && ((RS485_FRAME_POOL_NUM < 1) || (RS485_FRAME_POOL_NUM > 32))
+#error "RS485_FRAME_POOL_NUM must be 1~32, free frames are a 32 bits map"
+#endif
+
+#ifndef RS485_FRAME_SIZE
+#define RS485_FRAME_SIZE        256     //maximum length of a pool frame or a handler frame
+#endif
+
+#ifndef RS485_WORKER_STACK_SIZE
+#define RS485_WORKER_STACK_SIZE 2048    //stack size of default event loop thread used by rs485_set_frame_handler
+#endif
+
+#ifndef RS485_CRC_SLICES
+#define RS485_CRC_SLICES        1       //bytes processed per crc step, 1, 4 or 8, more is faster with larger tables
+#endif
+
+#ifndef RS485_RX_KEEP_SIZE
+#define RS485_RX_KEEP_SIZE      64      //datas kept after the end of a frame found by predicate, it limits the read chunk
+#endif
+
+#ifndef RS485_RX_RING_SIZE
+#define RS485_RX_RING_SIZE      1024    //receive ring size of each instance, power of 2
+#endif
+
+#ifndef RS485_TRACE_NUM
+#define RS485_TRACE_NUM         32      //entries of trace ring of each instance, power of 2
+#endif
+
+#ifndef RS485_TRACE_DATA
+#define RS485_TRACE_DATA        8       //leading datas of frame saved in a trace entry
+#endif
+
+#ifndef RS485_RTO_PEERS
+#define RS485_RTO_PEERS         8       //peers learned by each instance, the least recently used is replaced
+#endif
+
+#ifndef RS485_RTO_MIN
+#define RS485_RTO_MIN           10      //default floor of learned response timeout, ms
+#endif
+
+#ifndef RS485_RTO_MAX
+#define RS485_RTO_MAX           1000    //default ceiling of learned response timeout, ms
+#endif
+
+#ifndef RS485_SERIAL_V2_SLICE
+#define RS485_SERIAL_V2_SLICE   10      //longest blocking read of serial v2 backend, bounds latency of cancel and break, ms
+#endif
+
+#ifndef RS485_WORKER_PRIORITY
+#define RS485_WORKER_PRIORITY   8       //priority of default event loop thread used by rs485_set_frame_handler
+#endif
 
 #define RS485_BYTE_TMO_MIN      2
 #define RS485_BYTE_TMO_MAX      200
-#define RS485_SW_DLY_US         10
+#define RS485_BYTE_TMO_US_MIN   10      //minimum byte interval timeout, us
+#define RS485_BYTE_TMO_CHARS    35      //default byte interval timeout, 1/10 character time
+#define RS485_SW_DLY_US         10      //default delay after switching to send mode, us
+#define RS485_TX_SPIN_US_MAX    100     //longest drain delay spun in transmit complete interrupt, longer uses a timer, us
+#define RS485_GAP_SPIN_US_MAX   100     //longest rest of frame gap spun by receiver, longer sleeps a tick, us
+
+#define RS485_CONN_DMA_RX       (1<<0)  //open serial with dma receive, datas are indicated at idle line
+#define RS485_CONN_DMA_TX       (1<<1)  //open serial with dma transmit, enables asynchronous transmit
+#define RS485_CONN_HW_DE        (1<<2)  //the uart drives transceiver enable by RS485_CTRL_HW_DE, control pin is not written
+#define RS485_CONN_IDLE_END     (1<<3)  //with RS485_CONN_DMA_RX, the idle line indication ends the frame without the gap
+
+#ifndef RS485_CTRL_HW_DE
+#define RS485_CTRL_HW_DE        0x60    //serial control command of hardware direction, args is struct rs485_hw_de
+#endif
+
+#define RS485_TRACE_TX          0       //trace entry of send
+#define RS485_TRACE_RX          1       //trace entry of receive, timeout and break are receives without datas
 
 typedef struct rs485_inst rs485_inst_t;
 
+/* argument of serial control command RS485_CTRL_HW_DE, implemented by serial drivers of uarts driving 
+   the transceiver enable line themselves, such as the driver enable mode of stm32 usart */
+struct rs485_hw_de
+{
+    rt_uint8_t enable;      //1--the uart drives transceiver enable, 0--released to control pin
+    rt_uint8_t level;       //transceiver enable active level, 0--low, 1--high
+    rt_uint8_t ack;         //set to 1 by the driver applied it, drivers return RT_EOK for unknown commands
+    rt_uint16_t pre_us;     //assertion time before the start bit, us
+    rt_uint16_t post_us;    //deassertion time after the last stop bit, us
+};
+typedef struct rs485_hw_de rs485_hw_de_t;
+
+struct rs485_frame
+{
+    rt_uint8_t *data;       //frame datas, points into the frame pool of instance
+    int len;                //frame length
+};
+typedef struct rs485_frame rs485_frame_t;
+
+/* a segment of frame to send or to receive */
+struct rs485_iovec
+{
+    void *base;             //segment addr
+    int len;                //segment length
+};
+typedef struct rs485_iovec rs485_iovec_t;
+
+/* a transaction of batch, request and then response */
+struct rs485_xfer
+{
+    const void *send_buf;   //request addr
+    int send_len;           //request length
+    void *recv_buf;         //response buffer addr
+    int recv_size;          //response buffer size, 0--broadcast, no response
+    int timeout;            //response timeout, ms, 0--receive timeout of instance
+    int result;             //output, >0--length of response, 0--no response, <0--error
+};
+typedef struct rs485_xfer rs485_xfer_t;
+
+/* frame handler, called in worker thread for each completed frame, it can reply by rs485_send inline */
+typedef void (*rs485_frame_handler_t)(rs485_inst_t * hinst, const rt_uint8_t *buf, int len, void *ctx);
+
+/* frame completed predicate, called after each received chunk with the datas received so far,
+   returns 0 while the frame is not completed, or the frame length when it is known, so the receive 
+   returns without waiting the frame gap, datas after the frame length are kept for next receive, 
+   a length beyond the received datas is read up to. for receive segments, buf is the first segment 
+   and len the datas held in it, datas beyond it are not seen */
+typedef int (*rs485_frame_done_t)(const rt_uint8_t *buf, int len, void *ctx);
+
+/* asynchronous transmit completion, called in interrupt or timer context after the bus is switched to receive */
+typedef void (*rs485_send_cpl_t)(rs485_inst_t * hinst, int len, void *ctx);
+
+/* performance counters of instance, they wrap around */
+struct rs485_stats
+{
+    rt_uint32_t tx_bytes;       //sent datas
+    rt_uint32_t tx_frames;      //sent frames
+    rt_uint32_t rx_bytes;       //received datas
+    rt_uint32_t rx_frames;      //received frames
+    rt_uint32_t rx_timeouts;    //receives ended by timeout without datas, or by deadline inside a frame
+    rt_uint32_t rx_drops;       //received datas dropped on full receive ring
+    rt_uint32_t rx_gap_ends;    //frames ended by byte interval timeout, or idle line with RS485_CONN_IDLE_END
+    rt_uint32_t rx_breaks;      //receives broken by rs485_break_recv or rs485_cancel
+    rt_uint32_t mode_switches;  //writes of mode control pin
+    rt_uint32_t lock_takes;     //bus lock acquisitions
+    rt_uint32_t lock_wait_max_us;//longest wait of bus lock, us
+    rt_uint64_t lock_wait_us;   //total wait of bus lock, us
+    rt_uint32_t xfer_count;     //transactions answered, send then receive
+    rt_uint32_t xfer_min_us;    //transaction latency from send start to response end, us
+    rt_uint32_t xfer_avg_us;    //filled by rs485_get_stats
+    rt_uint32_t xfer_max_us;
+    rt_uint64_t xfer_sum_us;
+};
+typedef struct rs485_stats rs485_stats_t;
+
+/* trace entry of a send or a receive, 20 bytes with default RS485_TRACE_DATA */
+struct rs485_trace
+{
+    rt_uint32_t stamp;      //rs485_get_us when it ended
+    rt_uint8_t dir;         //RS485_TRACE_TX or RS485_TRACE_RX
+    rt_uint8_t cnt;         //datas saved in data
+    rt_uint16_t len;        //length of frame
+    rt_int16_t result;      //0--success, -RT_ETIMEOUT--receive timeout, -RT_EINTR--receive broken, -RT_EIO--send error
+    rt_uint8_t data[RS485_TRACE_DATA];//leading datas of frame
+};
+typedef struct rs485_trace rs485_trace_t;
+
+/* learned response timeout of a peer, smoothed like tcp retransmission timeout */
+struct rs485_rto
+{
+    rt_int32_t peer;        //peer id, -1--free entry
+    rt_uint32_t srtt_us;    //smoothed latency from the end of request to the first byte of response, us
+    rt_uint32_t rttvar_us;  //smoothed deviation of latency, us
+    rt_uint32_t rto_ms;     //response timeout of next transaction, ms
+    rt_uint32_t samples;    //latencies measured
+    rt_uint32_t timeouts;   //transactions without response, each one doubles the timeout
+    rt_tick_t stamp;        //tick of last transaction, the least recently used entry is replaced
+};
+typedef struct rs485_rto rs485_rto_t;
+
+#ifdef RS485_USING_FRAME_HANDLER
+typedef struct rs485_loop rs485_loop_t;
+typedef struct rs485_loop_timer rs485_loop_timer_t;
+
+/* loop timer callback, called in loop thread, it can start or stop timers of the loop */
+typedef void (*rs485_loop_timer_cb_t)(rs485_loop_timer_t *timer, void *ctx);
+
+/* timer dispatched by event loop thread, members are private */
+struct rs485_loop_timer
+{
+    rs485_loop_timer_t *next;   //next active timer, sorted by expire
+    rs485_loop_timer_cb_t cb;   //callback
+    void *ctx;                  //context of callback
+    rt_tick_t expire;           //tick of expire
+    rt_tick_t period;           //period ticks, 0--one shot
+    rt_uint8_t active;          //it is in the timer list
+};
+
+/* event loop, a thread services frames of many instances and timers, 
+   it is public to be allocated statically, the members are private */
+struct rs485_loop
+{
+    struct rt_mutex lock;       //protects instances and timers, held while dispatching
+    struct rt_event evt;        //a bit for each instance set by receive indication, the top bit wakes up the loop
+    rs485_inst_t *insts;        //registered instances
+    rs485_loop_timer_t *timers; //active timers
+    rt_uint8_t next_bit;        //event bit of next registered instance
+    struct rt_thread thread;
+};
+#endif
+
+/* instance, it is public to be allocated statically by rs485_init, the members are private */
+struct rs485_inst 
+{
+    rt_device_t serial;     //serial device handle
+    struct rt_mutex lock;   //bus mutex, held by transmits and by receives while a frame is arriving
+    struct rt_mutex rx_lock;//receive mutex, serializes receivers
+#ifndef RS485_USING_SERIAL_V2
+    struct rt_event evt;    //event
+#else
+    rt_int32_t rx_tmo_set;  //receive timeout set to serial v2 driver, ticks
+    volatile rt_uint32_t break_seq;//count of rs485_break_recv
+#endif
+    rt_uint8_t alloc;       //0--not initialized, 1--initialized statically, 2--created dynamically
+    rt_uint8_t status;      //connect status
+    rt_uint8_t flags;       //connect flags, RS485_CONN_xxx
+    rt_uint8_t level;       //control pin send mode level, 0--low, 1--high
+    rt_int16_t pin;         //control pin number used, -1--no using
+    rt_int32_t timeout;     //receive block timeout, ms   
+    rt_uint32_t byte_tmo;   //receive byte interval timeout, us
+    rt_uint32_t char_us;    //time of one character on the wire, us
+    rt_uint32_t rx_stamp;   //time of the last receive indication, us
+    volatile rt_uint32_t cancel_seq;//count of rs485_cancel, a blocking call started before a change returns
+    rt_uint16_t sw_pre_us;  //delay after switching to send mode, us
+    rt_uint16_t sw_post_us; //delay before switching to receive mode, us, drain of the last character
+    rt_uint8_t sw_post_auto;//switch post delay follows the character time
+    volatile rt_uint8_t tx_busy;//asynchronous transmit in progress, the bus is owned by it
+    volatile rt_uint16_t tx_cpl_cnt;//transmit complete indications of synchronous transmit
+    int tx_len;             //length of asynchronous transmit
+    rs485_send_cpl_t tx_cb; //completion callback of asynchronous transmit
+    void *tx_ctx;           //context of completion callback
+    struct rt_timer tx_timer;//drain timer of asynchronous transmit
+    rt_uint8_t rx_crc_type; //crc type updated over received datas, RS485_CRC_xxx
+    rt_uint32_t rx_crc;     //running crc of the last received frame
+    rt_uint16_t keep_pos;   //read position of kept datas
+    rt_uint16_t keep_len;   //length of kept datas
+    rt_uint8_t keep_buf[RS485_RX_KEEP_SIZE];//datas received after the end of last frame, read first by next receive
+#ifdef RS485_USING_RX_RING
+    volatile rt_uint32_t ring_head;//datas put by receive indication, free running, written by it only
+    volatile rt_uint32_t ring_tail;//datas taken by receivers, free running, written by them only
+    rt_uint8_t ring[RS485_RX_RING_SIZE];
+#endif
+#ifdef RS485_USING_STATS
+    struct rs485_stats stats;//performance counters
+#endif
+#ifdef RS485_USING_TRACE
+    rt_uint32_t trace_head; //entries recorded, the newest is at (trace_head - 1) % RS485_TRACE_NUM
+    struct rs485_trace trace[RS485_TRACE_NUM];
+#endif
+#ifdef RS485_USING_RTO
+    rt_uint32_t rx_first;   //time of the first receive indication after last request, us
+    volatile rt_uint8_t rx_first_wait;//the next receive indication is the first after request
+    rt_uint16_t rto_min;    //floor of learned response timeout, ms
+    rt_uint16_t rto_max;    //ceiling of learned response timeout, ms
+    struct rs485_rto rto[RS485_RTO_PEERS];
+#endif
+#ifdef RS485_USING_FRAME_POOL
+    rt_uint32_t frame_free; //free frames bitmap of frame pool
+    struct rs485_frame frames[RS485_FRAME_POOL_NUM];
+    rt_uint8_t frame_buf[RS485_FRAME_POOL_NUM][RS485_FRAME_SIZE];
+#endif
+#ifdef RS485_USING_FRAME_HANDLER
+    rs485_frame_handler_t handler;  //frame handler called by loop thread
+    void *handler_ctx;      //context of frame handler
+    rs485_loop_t *loop;     //event loop it is registered in, NULL--not registered
+    rs485_inst_t *loop_next;//next instance of the loop
+    rt_uint32_t loop_bit;   //event bit in the loop, it may be shared by instances
+    int asm_len;            //length of frame being assembled by loop
+    rt_uint32_t asm_crc;    //running crc of frame being assembled by loop
+    rt_uint8_t asm_buf[RS485_FRAME_SIZE];
+#endif
+};
+
+/* 
+ * @brief   initialize rs485 instance statically, no heap is used
+ * @param   hinst       - instance to initialize, global or static storage
+ * @param   serial      - serial device name
+ * @param   baudrate    - serial baud rate
+ * @param   parity      - serial parity mode
+ * @param   pin         - mode contrle pin
+ * @param   level       - send mode level
+ * @retval  0 - success, other - error
+ */
+int rs485_init(rs485_inst_t * hinst, const char *serial, int baudrate, int parity, int pin, int level);
+
+/* 
+ * @brief   detach rs485 instance initialized statically
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_detach(rs485_inst_t * hinst);
+
 /* 
  * @brief   create rs485 instance dynamically
  * @param   serial      - serial device name
@@ -72,12 +425,65 @@ int rs485_set_recv_tmo(rs485_inst_t * hinst, int tmo_ms);
 int rs485_set_byte_tmo(rs485_inst_t * hinst, int tmo_ms);
 
 /* 
- * @brief   open rs485 connect
+ * @brief   set byte interval timeout for receiving in microseconds
+ * @param   hinst       - instance handle
+ * @param   tmo_us      - byte interval timeout, us
+ * @retval  0 - success, other - error
+ */
+int rs485_set_byte_tmo_us(rs485_inst_t * hinst, int tmo_us);
+
+/* 
+ * @brief   set byte interval timeout for receiving in character times
+ * @param   hinst       - instance handle
+ * @param   chars_x10   - byte interval timeout, 1/10 character time, 35 -- 3.5 characters
+ * @retval  0 - success, other - error
+ */
+int rs485_set_byte_tmo_char(rs485_inst_t * hinst, int chars_x10);
+
+/* 
+ * @brief   set delays of switching transceiver direction
+ * @param   hinst       - instance handle
+ * @param   pre_us      - delay after switching to send mode, us, <0--default RS485_SW_DLY_US
+ * @param   post_us     - delay before switching to receive mode after datas are written, us,
+ *                        <0--one character time of current config, the drain of uart shift register
+ *                        with hardware direction control they are the assertion and deassertion times of uart,
+ *                        the default post delay is 0, the uart deasserts after the last stop bit
+ * @retval  0 - success, other - error
+ */
+int rs485_set_sw_dly(rs485_inst_t * hinst, int pre_us, int post_us);
+
+/* 
+ * @brief   get free running microsecond counter used by frame gap detection,
+ *          tick resolution by default, board can override it with a hardware timer and define RS485_USING_US_CLOCK,
+ *          without it frame gaps are rounded up to whole ticks
+ * @retval  microseconds
+ */
+rt_uint32_t rs485_get_us(void);
+
+/* 
+ * @brief   open rs485 connect, with RS485_USING_HW_DE it requests hardware direction control like RS485_CONN_HW_DE
  * @param   hinst       - instance handle
  * @retval  0 - success, other - error
  */
 int rs485_connect(rs485_inst_t * hinst);
 
+/* 
+ * @brief   open rs485 connect with options
+ * @param   hinst       - instance handle
+ * @param   flags       - connect flags, RS485_CONN_xxx
+ *                        RS485_CONN_DMA_RX - receive by dma, datas are indicated at idle line of serial driver,
+ *                        the frame still ends at the frame gap, the dma buffer of driver should hold the longest frame
+ *                        RS485_CONN_IDLE_END - with RS485_CONN_DMA_RX, the idle line indication ends the frame, 
+ *                        it returns about the frame gap earlier, but a pause longer than a character inside 
+ *                        a frame splits it, use it for devices sending frames back to back
+ *                        RS485_CONN_DMA_TX - transmit by dma, rs485_send_async returns while datas go out
+ *                        RS485_CONN_HW_DE - the uart drives transceiver enable with switch delays of instance,
+ *                        falls back to control pin when serial driver does not support RS485_CTRL_HW_DE
+ *                        with RS485_USING_SERIAL_V2 the dma flags are ignored, the driver config selects dma
+ * @retval  0 - success, other - error
+ */
+int rs485_connect_ex(rs485_inst_t * hinst, int flags);
+
 /* 
  * @brief   close rs485 connect
  * @param   hinst       - instance handle
@@ -86,7 +492,8 @@ int rs485_connect(rs485_inst_t * hinst);
 int rs485_disconn(rs485_inst_t * hinst);
 
 /* 
- * @brief   receive datas from rs485
+ * @brief   receive datas from rs485, the bus is not held while waiting the first byte,
+ *          so transmits of other threads are not blocked by the wait
  * @param   hinst       - instance handle
  * @param   buf         - buffer addr
  * @param   size        - maximum length of received datas
@@ -94,6 +501,44 @@ int rs485_disconn(rs485_inst_t * hinst);
  */
 int rs485_recv(rs485_inst_t * hinst, void *buf, int size);
 
+/* 
+ * @brief   receive datas from rs485, it returns as soon as the predicate reports the frame completed,
+ *          without waiting the frame gap
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @param   done        - frame completed predicate, called after each chunk received, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_recv_ex(rs485_inst_t * hinst, void *buf, int size, rs485_frame_done_t done, void *ctx);
+
+/* 
+ * @brief   receive datas from rs485 until an absolute deadline, the frame still arriving at the deadline 
+ *          is dropped, so a chattering device can not extend the call
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @param   deadline    - tick the call returns by, such as rt_tick_get() + rt_tick_from_millisecond(ms)
+ * @retval  >0 - length of received datas, 0 - no datas before the deadline, 
+ *          -RT_ETIMEOUT - the deadline passed inside a frame, -RT_EINTR - cancelled, other <0 - error
+ */
+int rs485_recv_dl(rs485_inst_t * hinst, void *buf, int size, rs485_frame_done_t done, void *ctx, rt_tick_t deadline);
+
+/* 
+ * @brief   receive datas from rs485 until the delimiter is received, it returns as soon as the delimiter is seen,
+ *          datas received after the delimiter are kept for next receive
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @param   delim       - delimiter
+ * @param   dlen        - length of delimiter
+ * @retval  >=0 - length of received datas including delimiter, <0 - error
+ */
+int rs485_recv_until(rs485_inst_t * hinst, void *buf, int size, const void *delim, int dlen);
+
 /* 
  * @brief   send datas to rs485
  * @param   hinst       - instance handle
@@ -103,6 +548,49 @@ int rs485_recv(rs485_inst_t * hinst, void *buf, int size);
  */
 int rs485_send(rs485_inst_t * hinst, void *buf, int size);
 
+/* 
+ * @brief   send datas to rs485 if the bus is got before an absolute deadline, 
+ *          the transmit itself is not broken, it is bounded by the wire time
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - length of send datas
+ * @param   deadline    - tick the bus must be got by
+ * @retval  >=0 - length of sent datas, -RT_ETIMEOUT - the bus was not got before the deadline, 
+ *          -RT_EINTR - cancelled, other <0 - error
+ */
+int rs485_send_dl(rs485_inst_t * hinst, const void *buf, int size, rt_tick_t deadline);
+
+/* 
+ * @brief   send datas gathered from segments to rs485 as one frame, the segments are written
+ *          back to back under one direction switch, no copy into a staging buffer
+ * @param   hinst       - instance handle
+ * @param   iov         - segments array
+ * @param   iovcnt      - count of segments
+ * @retval  >=0 - length of sent datas, <0 - error
+ */
+int rs485_sendv(rs485_inst_t * hinst, const rs485_iovec_t *iov, int iovcnt);
+
+/* 
+ * @brief   send datas to rs485 asynchronously, returns when the datas are queued to dma transmit.
+ *          the transmit complete indication switches the bus to receive and then calls cb.
+ *          without RS485_CONN_DMA_TX connect it sends synchronously and calls cb before returns.
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr, it must be kept until the completion
+ * @param   size        - length of send datas
+ * @param   cb          - completion callback, can be NULL
+ * @param   ctx         - context passed to cb
+ * @retval  0 - success, other - error
+ */
+int rs485_send_async(rs485_inst_t * hinst, const void *buf, int size, rs485_send_cpl_t cb, void *ctx);
+
+/* 
+ * @brief   wait the asynchronous transmit completed
+ * @param   hinst       - instance handle
+ * @param   tmo_ms      - wait timeout, ms, RT_WAITING_FOREVER--wait forever
+ * @retval  0 - success, -RT_ETIMEOUT - timeout, other - error
+ */
+int rs485_send_wait(rs485_inst_t * hinst, int tmo_ms);
+
 /* 
  * @brief   break rs485 receive wait
  * @param   hinst       - instance handle
@@ -110,6 +598,15 @@ int rs485_send(rs485_inst_t * hinst, void *buf, int size);
  */
 int rs485_break_recv(rs485_inst_t * hinst);
 
+/* 
+ * @brief   cancel blocking calls in progress on instance, they return -RT_EINTR promptly from any wait, 
+ *          of the bus, an asynchronous transmit, the first byte or the frame gap, a transmit in progress completes first, 
+ *          calls started after it are not affected, it can be called from interrupt
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_cancel(rs485_inst_t * hinst);
+
 /* 
  * @brief   send data to rs485 and then receive response data from rs485
  * @param   hinst       - instance handle
@@ -121,6 +618,325 @@ int rs485_break_recv(rs485_inst_t * hinst);
  */
 int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, void *recv_buf, int recv_size);
 
+/* 
+ * @brief   send data to rs485 and then receive response data from rs485, 
+ *          it returns as soon as the predicate reports the response completed, without waiting the frame gap
+ * @param   hinst       - instance handle
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @param   done        - frame completed predicate, called after each chunk received, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_send_then_recv_ex(rs485_inst_t * hinst, const void *send_buf, int send_len, void *recv_buf, int recv_size, 
+                            rs485_frame_done_t done, void *ctx);
+
+/* 
+ * @brief   send data to rs485 and then receive response data from rs485 until the delimiter is received,
+ *          it returns as soon as the delimiter is seen, datas received after the delimiter are kept for next receive
+ * @param   hinst       - instance handle
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @param   delim       - delimiter
+ * @param   dlen        - length of delimiter
+ * @retval  >=0 - length of received datas including delimiter, <0 - error
+ */
+int rs485_send_then_recv_until(rs485_inst_t * hinst, const void *send_buf, int send_len, void *recv_buf, int recv_size, 
+                                const void *delim, int dlen);
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response data from rs485
+ * @param   hinst       - instance handle
+ * @param   iov         - send segments array
+ * @param   iovcnt      - count of send segments
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_send_then_recvv(rs485_inst_t * hinst, const rs485_iovec_t *iov, int iovcnt, void *recv_buf, int recv_size);
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response scattered into segments,
+ *          the receive completes when all receive segments are filled or the frame gap elapses
+ * @param   hinst       - instance handle
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, 0--no response
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_transferv(rs485_inst_t * hinst, const rs485_iovec_t *send_iov, int send_cnt, 
+                    const rs485_iovec_t *recv_iov, int recv_cnt);
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response scattered into segments,
+ *          the receive completes when all receive segments are filled, the predicate reports 
+ *          the response completed or the frame gap elapses
+ * @param   hinst       - instance handle
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, 0--no response
+ * @param   done        - frame completed predicate, it sees the datas held in the first receive segment,
+ *                        NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_transferv_ex(rs485_inst_t * hinst, const rs485_iovec_t *send_iov, int send_cnt, 
+                        const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx);
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response scattered into segments,
+ *          the whole transaction ends by an absolute deadline instead of the receive timeout of instance,
+ *          a response still arriving at the deadline is dropped, so a chattering device can not extend it
+ * @param   hinst       - instance handle
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, 0--no response
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @param   deadline    - tick the call returns by, such as rt_tick_get() + rt_tick_from_millisecond(ms)
+ * @retval  >0 - length of received datas, 0 - no response before the deadline, -RT_ETIMEOUT - the deadline 
+ *          passed before the bus was got or inside the response, -RT_EINTR - cancelled, other <0 - error
+ */
+int rs485_transferv_dl(rs485_inst_t * hinst, const rs485_iovec_t *send_iov, int send_cnt, 
+                        const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx, 
+                        rt_tick_t deadline);
+
+/* 
+ * @brief   send data to rs485 and then receive response data from rs485 by an absolute deadline,
+ *          stale datas are discarded before sending like rs485_transferv_dl
+ * @param   hinst       - instance handle
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @param   deadline    - tick the call returns by
+ * @retval  same as rs485_transferv_dl
+ */
+int rs485_send_then_recv_dl(rs485_inst_t * hinst, const void *send_buf, int send_len, void *recv_buf, int recv_size, 
+                            rs485_frame_done_t done, void *ctx, rt_tick_t deadline);
+
+/* 
+ * @brief   run transactions back to back under one bus acquisition
+ * @param   hinst       - instance handle
+ * @param   xfers       - transactions array, result of each one is filled in
+ * @param   count       - count of transactions
+ * @retval  >=0 - count of transactions received response, <0 - error
+ */
+int rs485_transact_batch(rs485_inst_t * hinst, rs485_xfer_t *xfers, int count);
+
+/* 
+ * @brief   set crc updated over received datas, it is calculated while the frame is arriving 
+ * @param   hinst       - instance handle
+ * @param   type        - crc type, RS485_CRC_NONE, RS485_CRC_16 or RS485_CRC_32, see rs485_crc.h
+ * @retval  0 - success, other - error
+ */
+int rs485_set_rx_crc(rs485_inst_t * hinst, int type);
+
+/* 
+ * @brief   get crc over the last received frame including its crc, the frame is valid 
+ *          when it equals RS485_CRC16_RESIDUE or RS485_CRC32_RESIDUE
+ * @param   hinst       - instance handle
+ * @retval  crc value
+ */
+rt_uint32_t rs485_get_rx_crc(rs485_inst_t * hinst);
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response scattered into segments,
+ *          the crc over the response is returned by the call, so it is not changed by other receivers 
+ *          of instance and the crc type of instance is kept
+ * @param   hinst       - instance handle
+ * @param   peer        - peer id the response timeout is learned for with RS485_USING_RTO, 
+ *                        <0--receive timeout of instance
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, >0
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @param   crc_type    - crc type of this response, RS485_CRC_16 or RS485_CRC_32
+ * @param   crc         - output, crc over the response including its crc, the response is valid 
+ *                        when it equals RS485_CRC16_RESIDUE or RS485_CRC32_RESIDUE
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_transferv_crc(rs485_inst_t * hinst, int peer, const rs485_iovec_t *send_iov, int send_cnt, 
+                        const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx, 
+                        int crc_type, rt_uint32_t *crc);
+
+#ifdef RS485_USING_STATS
+/* 
+ * @brief   get performance counters of instance
+ * @param   hinst       - instance handle
+ * @param   stats       - output, copy of counters
+ * @retval  0 - success, other - error
+ */
+int rs485_get_stats(rs485_inst_t * hinst, rs485_stats_t *stats);
+
+/* 
+ * @brief   clear performance counters of instance
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_reset_stats(rs485_inst_t * hinst);
+#endif
+
+#ifdef RS485_USING_TRACE
+/* 
+ * @brief   get the newest entries of trace ring
+ * @param   hinst       - instance handle
+ * @param   entries     - output, entries from the oldest to the newest
+ * @param   num         - maximum count of entries
+ * @retval  >=0 - count of entries, <0 - error
+ */
+int rs485_get_trace(rs485_inst_t * hinst, rs485_trace_t *entries, int num);
+
+/* 
+ * @brief   clear trace ring of instance
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_clear_trace(rs485_inst_t * hinst);
+#endif
+
+#ifdef RS485_USING_RTO
+/* 
+ * @brief   send data to a peer and then receive its response, the response timeout is learned 
+ *          from the latency of the peer instead of the receive timeout of instance
+ * @param   hinst       - instance handle
+ * @param   peer        - peer id, such as slave address, >=0
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_send_then_recv_peer(rs485_inst_t * hinst, int peer, const void *send_buf, int send_len, 
+                                void *recv_buf, int recv_size);
+
+/* 
+ * @brief   send datas gathered from segments to a peer and then receive its response scattered into segments,
+ *          the response timeout is learned from the latency of the peer
+ * @param   hinst       - instance handle
+ * @param   peer        - peer id, such as slave address, >=0
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, >0
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_transferv_peer(rs485_inst_t * hinst, int peer, const rs485_iovec_t *send_iov, int send_cnt, 
+                        const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx);
+
+/* 
+ * @brief   set floor and ceiling of learned response timeout, the learned values are cleared
+ * @param   hinst       - instance handle
+ * @param   min_ms      - floor, ms, 0--RS485_RTO_MIN
+ * @param   max_ms      - ceiling, ms, 0--RS485_RTO_MAX
+ * @retval  0 - success, other - error
+ */
+int rs485_set_rto(rs485_inst_t * hinst, int min_ms, int max_ms);
+
+/* 
+ * @brief   get learned response timeouts of peers
+ * @param   hinst       - instance handle
+ * @param   entries     - output, learned values of peers
+ * @param   num         - maximum count of entries
+ * @retval  >=0 - count of entries, <0 - error
+ */
+int rs485_get_rto(rs485_inst_t * hinst, rs485_rto_t *entries, int num);
+#endif
+
+#ifdef RS485_USING_FRAME_POOL
+/* 
+ * @brief   receive a frame into the frame pool of instance
+ * @param   hinst       - instance handle
+ * @param   frame       - output, the received frame, release it by rs485_frame_release after used
+ * @retval  >0 - length of received frame, 0 - timeout, <0 - error
+ */
+int rs485_recv_frame(rs485_inst_t * hinst, rs485_frame_t ** frame);
+
+/* 
+ * @brief   release a frame back to the frame pool of instance
+ * @param   hinst       - instance handle
+ * @param   frame       - frame received by rs485_recv_frame
+ * @retval  0 - success, other - error
+ */
+int rs485_frame_release(rs485_inst_t * hinst, rs485_frame_t * frame);
+#endif
+
+#ifdef RS485_USING_FRAME_HANDLER
+/* 
+ * @brief   set frame handler, the default event loop thread owns reception of the instance
+ *          and calls the handler once for each completed frame
+ * @param   hinst       - instance handle
+ * @param   handler     - frame handler, NULL--remove handler
+ * @param   ctx         - context passed to handler
+ * @retval  0 - success, other - error
+ */
+int rs485_set_frame_handler(rs485_inst_t * hinst, rs485_frame_handler_t handler, void *ctx);
+
+/* 
+ * @brief   initialize an event loop and start its thread, no heap is used,
+ *          the loop sleeps on its event only, so a frame ends up to a tick after its gap
+ * @param   loop        - loop to initialize, global or static storage
+ * @param   name        - name of loop thread
+ * @param   stack       - stack of loop thread
+ * @param   stack_size  - stack size
+ * @param   priority    - priority of loop thread
+ * @retval  0 - success, other - error
+ */
+int rs485_loop_init(rs485_loop_t *loop, const char *name, void *stack, int stack_size, int priority);
+
+/* 
+ * @brief   register instance in event loop, the loop thread owns reception of the instance
+ *          and calls the handler once for each completed frame, any number of instances can be registered
+ * @param   loop        - loop handle
+ * @param   hinst       - instance handle
+ * @param   handler     - frame handler
+ * @param   ctx         - context passed to handler
+ * @retval  0 - success, other - error
+ */
+int rs485_loop_add(rs485_loop_t *loop, rs485_inst_t * hinst, rs485_frame_handler_t handler, void *ctx);
+
+/* 
+ * @brief   unregister instance from its event loop
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_loop_remove(rs485_inst_t * hinst);
+
+/* 
+ * @brief   start a timer dispatched by event loop thread, a started timer is restarted
+ * @param   loop        - loop handle
+ * @param   timer       - timer, global or static storage
+ * @param   cb          - callback
+ * @param   ctx         - context passed to callback
+ * @param   tmo_ms      - timeout, ms
+ * @param   periodic    - 0--one shot, 1--periodic
+ * @retval  0 - success, other - error
+ */
+int rs485_loop_timer_start(rs485_loop_t *loop, rs485_loop_timer_t *timer, rs485_loop_timer_cb_t cb, void *ctx, 
+                            int tmo_ms, int periodic);
+
+/* 
+ * @brief   stop a timer of event loop
+ * @param   loop        - loop handle
+ * @param   timer       - timer
+ * @retval  0 - success, other - error
+ */
+int rs485_loop_timer_stop(rs485_loop_t *loop, rs485_loop_timer_t *timer);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
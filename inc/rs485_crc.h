@@ -0,0 +1,64 @@
+/*
+ * rs485_crc.h
+ *
+ * crc16 (modbus) and crc32 (ieee 802.3) calculation
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ */
+
+#ifndef __RS485_CRC_H__
+#define __RS485_CRC_H__
+
+#include <rs485.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define RS485_CRC_NONE          0       //no crc
+#define RS485_CRC_16            1       //crc16 of modbus, appended low byte first
+#define RS485_CRC_32            2       //crc32 of ieee 802.3, appended low byte first
+
+#define RS485_CRC16_INIT        0xFFFF
+#define RS485_CRC32_INIT        0x00000000
+#define RS485_CRC16_RESIDUE     0x0000      //crc16 over a valid frame including its crc
+#define RS485_CRC32_RESIDUE     0x2144DF1C  //crc32 over a valid frame including its crc
+
+/* 
+ * @brief   calculate modbus crc16, polynomial 0xA001 (reflected 0x8005), it can be calculated in parts
+ * @param   crc         - initial value, RS485_CRC16_INIT for a new frame, or the result of last part
+ * @param   buf         - datas addr
+ * @param   len         - length of datas
+ * @retval  crc value, low byte is sent first
+ */
+rt_uint16_t rs485_crc16(rt_uint16_t crc, const void *buf, int len);
+
+/* 
+ * @brief   calculate crc32 of ieee 802.3, polynomial 0xEDB88320 (reflected 0x04C11DB7), 
+ *          the result is inverted as zlib does, so it can be calculated in parts
+ * @param   crc         - initial value, RS485_CRC32_INIT for a new frame, or the result of last part
+ * @param   buf         - datas addr
+ * @param   len         - length of datas
+ * @retval  crc value, low byte is sent first
+ */
+rt_uint32_t rs485_crc32(rt_uint32_t crc, const void *buf, int len);
+
+/* 
+ * @brief   update running crc of a receive
+ * @param   type        - crc type, RS485_CRC_16 or RS485_CRC_32
+ * @param   crc         - running crc
+ * @param   buf         - datas addr
+ * @param   len         - length of datas
+ * @retval  crc value
+ */
+rt_uint32_t rs485_crc_update(int type, rt_uint32_t crc, const void *buf, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,313 @@
+/*
+ * rs485_modbus.h
+ *
+ * modbus rtu master and slave on rs485 instance
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       add slave
+ */
+
+#ifndef __RS485_MODBUS_H__
+#define __RS485_MODBUS_H__
+
+#include <rs485.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef RS485_USING_MODBUS
+
+#define RS485_MB_ADU_MAX            256     //maximum length of modbus rtu frame
+
+#define RS485_MB_READ_BITS_MAX      2000    //maximum coils or discrete inputs of a read
+#define RS485_MB_READ_REGS_MAX      125     //maximum registers of a read
+#define RS485_MB_WRITE_BITS_MAX     1968    //maximum coils of a write
+#define RS485_MB_WRITE_REGS_MAX     123     //maximum registers of a write
+#define RS485_MB_RW_WRITE_REGS_MAX  121     //maximum registers written by read/write multiple registers
+#define RS485_MB_EVENT_LOG_MAX      64      //maximum events of comm event log
+
+/* function codes */
+#define RS485_MB_FC_READ_COILS          0x01
+#define RS485_MB_FC_READ_DISC_INPUTS    0x02
+#define RS485_MB_FC_READ_HOLD_REGS      0x03
+#define RS485_MB_FC_READ_INPUT_REGS     0x04
+#define RS485_MB_FC_WRITE_COIL          0x05
+#define RS485_MB_FC_WRITE_REG           0x06
+#define RS485_MB_FC_READ_EXCEPT_STATUS  0x07
+#define RS485_MB_FC_DIAGNOSTICS         0x08
+#define RS485_MB_FC_GET_EVENT_COUNTER   0x0B
+#define RS485_MB_FC_GET_EVENT_LOG       0x0C
+#define RS485_MB_FC_WRITE_COILS         0x0F
+#define RS485_MB_FC_WRITE_REGS          0x10
+#define RS485_MB_FC_RW_REGS             0x17
+
+/* exception codes, returned as positive value by the master functions */
+#define RS485_MB_EX_ILLEGAL_FUNCTION    0x01
+#define RS485_MB_EX_ILLEGAL_ADDRESS     0x02
+#define RS485_MB_EX_ILLEGAL_VALUE       0x03
+#define RS485_MB_EX_DEVICE_FAILURE      0x04
+#define RS485_MB_EX_ACKNOWLEDGE         0x05
+#define RS485_MB_EX_DEVICE_BUSY         0x06
+
+/*
+ * the master functions send a request and wait the response in the receive timeout of instance.
+ * slave 0 is broadcast, only the write functions accept it and they return without response.
+ * the response completes when its last byte arrives, its length is computed from the request.
+ * return of master functions : 0 - success, >0 - exception code replied by slave,
+ *                              -RT_ETIMEOUT - no response, -RT_EIO - bad response, other <0 - error
+ */
+
+/* 
+ * @brief   calculate modbus crc16
+ * @param   crc         - initial value, 0xFFFF for a new frame, or the result of last part
+ * @param   buf         - datas addr
+ * @param   len         - length of datas
+ * @retval  crc value, low byte is sent first
+ */
+rt_uint16_t rs485_mb_crc16(rt_uint16_t crc, const void *buf, int len);
+
+/* 
+ * @brief   read coils (0x01), the status are packed into bits as the wire order, the first coil in bit0 of bits[0]
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of coils, 1~2000
+ * @param   bits        - output, coils status, (num + 7) / 8 bytes
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_coils(rs485_inst_t * hinst, int slave, int addr, int num, rt_uint8_t *bits);
+
+/* 
+ * @brief   read discrete inputs (0x02), the status are packed into bits as rs485_mb_read_coils
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of inputs, 1~2000
+ * @param   bits        - output, inputs status, (num + 7) / 8 bytes
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_disc_inputs(rs485_inst_t * hinst, int slave, int addr, int num, rt_uint8_t *bits);
+
+/* 
+ * @brief   read holding registers (0x03), the registers are received into regs directly
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of registers, 1~125
+ * @param   regs        - output, registers value, the content is undefined when it fails
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_hold_regs(rs485_inst_t * hinst, int slave, int addr, int num, rt_uint16_t *regs);
+
+/* 
+ * @brief   read input registers (0x04), the registers are received into regs directly
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of registers, 1~125
+ * @param   regs        - output, registers value, the content is undefined when it fails
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_input_regs(rs485_inst_t * hinst, int slave, int addr, int num, rt_uint16_t *regs);
+
+/* 
+ * @brief   write single coil (0x05)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 0~247
+ * @param   addr        - coil address
+ * @param   on          - 0--off, other--on
+ * @retval  see return of master functions
+ */
+int rs485_mb_write_coil(rs485_inst_t * hinst, int slave, int addr, int on);
+
+/* 
+ * @brief   write single register (0x06)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 0~247
+ * @param   addr        - register address
+ * @param   value       - register value
+ * @retval  see return of master functions
+ */
+int rs485_mb_write_reg(rs485_inst_t * hinst, int slave, int addr, rt_uint16_t value);
+
+/* 
+ * @brief   read exception status (0x07)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   status      - output, exception status
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_except_status(rs485_inst_t * hinst, int slave, rt_uint8_t *status);
+
+/* 
+ * @brief   diagnostics (0x08), for the sub-functions answered with sub-function and a data word
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   sub_func    - sub-function code, 0x0000--return query data
+ * @param   data        - request data
+ * @param   result      - output, response data, can be NULL
+ * @retval  see return of master functions
+ */
+int rs485_mb_diagnostics(rs485_inst_t * hinst, int slave, rt_uint16_t sub_func, rt_uint16_t data, rt_uint16_t *result);
+
+/* 
+ * @brief   get comm event counter (0x0B)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   status      - output, status word, can be NULL
+ * @param   count       - output, event count, can be NULL
+ * @retval  see return of master functions
+ */
+int rs485_mb_get_event_counter(rs485_inst_t * hinst, int slave, rt_uint16_t *status, rt_uint16_t *count);
+
+/* 
+ * @brief   get comm event log (0x0C), the response length is variable, it completes at frame gap
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   status      - output, status word, can be NULL
+ * @param   event_count - output, event count, can be NULL
+ * @param   msg_count   - output, message count, can be NULL
+ * @param   events      - output, event bytes, the most recent first, RS485_MB_EVENT_LOG_MAX bytes, can be NULL
+ * @param   event_num   - output, count of event bytes, can be NULL
+ * @retval  see return of master functions
+ */
+int rs485_mb_get_event_log(rs485_inst_t * hinst, int slave, rt_uint16_t *status, rt_uint16_t *event_count,
+                            rt_uint16_t *msg_count, rt_uint8_t *events, int *event_num);
+
+/* 
+ * @brief   write multiple coils (0x0F), the status are packed into bits as rs485_mb_read_coils
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 0~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of coils, 1~1968
+ * @param   bits        - coils status, (num + 7) / 8 bytes
+ * @retval  see return of master functions
+ */
+int rs485_mb_write_coils(rs485_inst_t * hinst, int slave, int addr, int num, const rt_uint8_t *bits);
+
+/* 
+ * @brief   write multiple registers (0x10)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 0~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of registers, 1~123
+ * @param   regs        - registers value
+ * @retval  see return of master functions
+ */
+int rs485_mb_write_regs(rs485_inst_t * hinst, int slave, int addr, int num, const rt_uint16_t *regs);
+
+/* 
+ * @brief   read/write multiple registers (0x17), the write is done before the read by slave
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   rd_addr     - read starting address
+ * @param   rd_num      - quantity to read, 1~125
+ * @param   rd_regs     - output, registers read, the content is undefined when it fails
+ * @param   wr_addr     - write starting address
+ * @param   wr_num      - quantity to write, 1~121
+ * @param   wr_regs     - registers value to write
+ * @retval  see return of master functions
+ */
+int rs485_mb_rw_regs(rs485_inst_t * hinst, int slave, int rd_addr, int rd_num, rt_uint16_t *rd_regs,
+                        int wr_addr, int wr_num, const rt_uint16_t *wr_regs);
+
+#endif
+
+#ifdef RS485_USING_MODBUS_SLAVE
+
+/* register tables of slave */
+#define RS485_MB_COILS          0       //coils, read and write, bits
+#define RS485_MB_DISC_INPUTS    1       //discrete inputs, read only, bits
+#define RS485_MB_HOLD_REGS      2       //holding registers, read and write
+#define RS485_MB_INPUT_REGS     3       //input registers, read only
+#define RS485_MB_TABLES         4
+
+/*
+ * access callback of a register range, addr is the protocol address, num is the count of registers or bits.
+ * registers are in cpu order, bits are packed as the wire order, the first one in bit0 of buf[0].
+ * it is called in frame handler worker thread, returns 0 - success, >0 - exception code replied to master.
+ */
+typedef int (*rs485_mb_access_t)(void *ctx, int addr, int num, void *buf);
+
+/* a register range of slave table, bound to memory or to callbacks */
+struct rs485_mb_map
+{
+    rt_uint16_t start;          //first address of range
+    rt_uint16_t num;            //count of registers or bits of range
+    void *mem;                  //memory binding, rt_uint16_t array of registers or packed bits, NULL--use callbacks
+    rs485_mb_access_t read;     //read callback, used when mem is NULL
+    rs485_mb_access_t write;    //write callback, NULL--write to mem, NULL with mem NULL--read only
+    void *ctx;                  //context passed to callbacks
+};
+typedef struct rs485_mb_map rs485_mb_map_t;
+
+/* slave instance, allocated by user, no heap is used by the slave engine */
+struct rs485_mb_slave
+{
+    rs485_inst_t *hinst;        //rs485 instance
+    rt_uint8_t addr;            //slave address
+    rt_uint16_t event_count;    //count of successfully completed messages, comm event counter
+    rt_uint32_t msg_count;      //count of messages addressed to this slave
+    rt_uint32_t err_count;      //count of crc error messages
+    const rs485_mb_map_t *maps[RS485_MB_TABLES];
+    int map_num[RS485_MB_TABLES];
+    rt_uint16_t regs[RS485_MB_READ_REGS_MAX];   //registers exchanged with callbacks
+    rt_uint8_t rsp[RS485_MB_ADU_MAX];           //response frame
+};
+typedef struct rs485_mb_slave rs485_mb_slave_t;
+
+/* 
+ * @brief   initialize modbus slave
+ * @param   slave       - slave instance
+ * @param   hinst       - rs485 instance, connected by user
+ * @param   addr        - slave address, 1~247
+ * @retval  0 - success, other - error
+ */
+int rs485_mb_slave_init(rs485_mb_slave_t * slave, rs485_inst_t * hinst, int addr);
+
+/* 
+ * @brief   set register maps of a table, the maps are used in place and should be kept
+ * @param   slave       - slave instance
+ * @param   table       - table, RS485_MB_COILS, RS485_MB_DISC_INPUTS, RS485_MB_HOLD_REGS, RS485_MB_INPUT_REGS
+ * @param   maps        - maps array, sorted by start address and not overlapped
+ * @param   num         - count of maps
+ * @retval  0 - success, other - error
+ */
+int rs485_mb_slave_set_map(rs485_mb_slave_t * slave, int table, const rs485_mb_map_t *maps, int num);
+
+/* 
+ * @brief   start modbus slave, requests are served by the frame handler worker thread
+ * @param   slave       - slave instance
+ * @retval  0 - success, other - error
+ */
+int rs485_mb_slave_start(rs485_mb_slave_t * slave);
+
+/* 
+ * @brief   stop modbus slave
+ * @param   slave       - slave instance
+ * @retval  0 - success, other - error
+ */
+int rs485_mb_slave_stop(rs485_mb_slave_t * slave);
+
+/* 
+ * @brief   process a request frame and send the response, it is the frame handler of slave,
+ *          the crc is taken from the running receive crc, so the frame should be the last one received by hinst
+ * @param   hinst       - rs485 instance
+ * @param   buf         - request frame
+ * @param   len         - length of request frame
+ * @param   ctx         - slave instance
+ * @retval  none
+ */
+void rs485_mb_slave_handler(rs485_inst_t * hinst, const rt_uint8_t *buf, int len, void *ctx);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
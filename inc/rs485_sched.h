@@ -0,0 +1,108 @@
+/*
+ * rs485_sched.h
+ *
+ * deadline based master poll scheduler on rs485 instance
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ */
+
+#ifndef __RS485_SCHED_H__
+#define __RS485_SCHED_H__
+
+#include <rs485.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef RS485_USING_SCHED
+
+#ifndef RS485_SCHED_BACKOFF_MAX
+#define RS485_SCHED_BACKOFF_MAX     30000   //default longest poll interval of a slave keeps timing out, ms
+#endif
+
+#define RS485_SCHED_BACKOFF_SHIFT   10      //maximum doubling of poll interval
+
+/* poll of an item, it runs transactions on the instance of scheduler,
+   returns 0 when the slave answered, -RT_ETIMEOUT when it did not, other <0 on error */
+typedef int (*rs485_poll_t)(rs485_inst_t * hinst, void *ctx);
+
+/* counters of a poll item, read only */
+struct rs485_poll_stats
+{
+    rt_uint32_t polls;      //polls run
+    rt_uint32_t timeouts;   //polls without answer
+    rt_uint32_t errors;     //polls failed by other errors
+    rt_uint32_t late_max;   //longest delay of poll start after its deadline, ticks
+    rt_uint32_t late_sum;   //total delay of poll start after deadline, ticks, average is late_sum / polls
+};
+typedef struct rs485_poll_stats rs485_poll_stats_t;
+
+/* poll item, global or static storage, members except stats are private */
+typedef struct rs485_poll_item rs485_poll_item_t;
+struct rs485_poll_item
+{
+    rs485_poll_item_t *next;//next item of scheduler
+    rs485_poll_t poll;      //poll function
+    void *ctx;              //context of poll function
+    rt_tick_t period;       //poll period, ticks
+    rt_tick_t deadline;     //tick the next poll is due
+    rt_uint8_t prio;        //priority between items due at the same tick, smaller is higher
+    rt_uint8_t fails;       //consecutive timeouts, the interval is period doubled by each one
+    struct rs485_poll_stats stats;
+};
+
+/* scheduler, global or static storage, members are private */
+struct rs485_sched
+{
+    rs485_inst_t *hinst;    //instance polled
+    rs485_poll_item_t *items;//poll items
+    rt_tick_t backoff_max;  //longest poll interval of a slave keeps timing out, ticks
+};
+typedef struct rs485_sched rs485_sched_t;
+
+/* 
+ * @brief   initialize poll scheduler
+ * @param   sched       - scheduler
+ * @param   hinst       - instance polled, connected by user
+ * @param   backoff_max - longest poll interval of a slave keeps timing out, ms, 0--RS485_SCHED_BACKOFF_MAX
+ * @retval  0 - success, other - error
+ */
+int rs485_sched_init(rs485_sched_t * sched, rs485_inst_t * hinst, int backoff_max);
+
+/* 
+ * @brief   add poll item to scheduler, it is due at once
+ * @param   sched       - scheduler
+ * @param   item        - poll item
+ * @param   poll        - poll function
+ * @param   ctx         - context passed to poll function
+ * @param   period      - poll period, ms
+ * @param   prio        - priority between items due at the same tick, smaller is higher
+ * @retval  0 - success, other - error
+ */
+int rs485_sched_add(rs485_sched_t * sched, rs485_poll_item_t * item, rs485_poll_t poll, void *ctx, int period, int prio);
+
+/* 
+ * @brief   remove poll item from scheduler
+ * @param   sched       - scheduler
+ * @param   item        - poll item
+ * @retval  0 - success, other - error
+ */
+int rs485_sched_remove(rs485_sched_t * sched, rs485_poll_item_t * item);
+
+/* 
+ * @brief   run the poll of the earliest deadline if it is due
+ * @param   sched       - scheduler
+ * @retval  ticks until the next poll is due, 0--a poll ran or is due, RT_WAITING_FOREVER--no item or error
+ */
+int rs485_sched_poll(rs485_sched_t * sched);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -8,12 +8,47 @@
  * 2020-12-17     qiyongzhong       fix log tag
  * 2020-12-18     qiyongzhong       add rs485_send_then_recv
  * 2023-09-19     qiyongzhong       add switch delay
+ * 2026-10-17     qiyongzhong       add microsecond frame gap detection
+ * 2026-10-17     qiyongzhong       add dma receive mode
+ * 2026-10-17     qiyongzhong       add zero copy frame receive
+ * 2026-10-17     qiyongzhong       add frame handler
+ * 2026-10-17     qiyongzhong       separate receive lock from bus lock
+ * 2026-10-17     qiyongzhong       add per instance switch delay from baudrate
+ * 2026-10-17     qiyongzhong       add asynchronous dma transmit
+ * 2026-10-17     qiyongzhong       add scatter gather transmit
+ * 2026-10-17     qiyongzhong       add batched transactions
+ * 2026-10-17     qiyongzhong       add scatter receive transfer
+ * 2026-10-17     qiyongzhong       add running crc of receive
+ * 2026-10-17     qiyongzhong       add receive completed by frame predicate
+ * 2026-10-17     qiyongzhong       add delimiter terminated receive
+ * 2026-10-17     qiyongzhong       add static instance init and detach
+ * 2026-10-17     qiyongzhong       add performance counters
+ * 2026-10-17     qiyongzhong       add traffic trace ring
+ * 2026-10-17     qiyongzhong       add event loop servicing many instances in one thread
+ * 2026-10-17     qiyongzhong       add adaptive per peer response timeout
+ * 2026-10-17     qiyongzhong       add receive ring filled by receive indication
+ * 2026-10-17     qiyongzhong       add cancel and deadline of blocking calls
+ * 2026-10-17     qiyongzhong       add hardware direction control of serial driver
+ * 2026-10-17     qiyongzhong       add serial framework v2 backend
+ * 2026-10-17     qiyongzhong       fix frame gap shorter than resolution of tick clock
+ * 2026-10-17     qiyongzhong       fix frame end of dma receive without frame gap
+ * 2026-10-17     qiyongzhong       fix ticks of transmit drain wait on disconnect
+ * 2026-10-17     qiyongzhong       fix predicate reading beyond first receive segment
+ * 2026-10-17     qiyongzhong       fix event loop spinning on frame gap
+ * 2026-10-17     qiyongzhong       fix response latency stamped by later receive indications
+ * 2026-10-17     qiyongzhong       add memory barriers of receive ring
+ * 2026-10-17     qiyongzhong       fix unbounded wait of asynchronous transmit
+ * 2026-10-17     qiyongzhong       fix batch going on after cancel in send
+ * 2026-10-17     qiyongzhong       add idle line frame end of dma receive as option
+ * 2026-10-17     qiyongzhong       return receive crc from the transaction
  */
 
 #include <rtthread.h>
 #include <rtdevice.h>
 #include <rthw.h>
 #include <rs485.h>
+#include <rs485_crc.h>
+#include <string.h>
 
 #define DBG_TAG "rs485"
 #define DBG_LVL DBG_INFO
@@ -21,524 +56,3533 @@
 
 #define RS485_EVT_RX_IND    (1<<0)
 #define RS485_EVT_RX_BREAK  (1<<1)
+#define RS485_EVT_TX_CPL    (1<<2)
+#define RS485_EVT_TX_DONE   (1<<3)
+#define RS485_EVT_CANCEL    (1<<4)
 
-struct rs485_inst 
+#define RS485_PIN_CTRL(hinst)   (((hinst)->pin >= 0) && (((hinst)->flags & RS485_CONN_HW_DE) == 0))//direction is switched by writing pin
+
+#define RS485_TICK_US       (1000000 / RT_TICK_PER_SECOND)
+
+#ifdef RS485_USING_STATS
+#define RS485_STAT_ADD(hinst, item, n)  ((hinst)->stats.item += (n))
+#define RS485_STAT_XFER(hinst, start)   rs485_stat_xfer(hinst, start)
+#else
+#define RS485_STAT_ADD(hinst, item, n)
+#define RS485_STAT_XFER(hinst, start)   ((void)(start))
+#endif
+
+#ifdef RS485_USING_TRACE
+#if (RS485_TRACE_NUM & (RS485_TRACE_NUM - 1)) != 0
+#error "RS485_TRACE_NUM must be power of 2"
+#endif
+#define RS485_TRACE(hinst, dir, iov, iovcnt, len, result)   rs485_trace_put(hinst, dir, iov, iovcnt, len, result)
+#else
+#define RS485_TRACE(hinst, dir, iov, iovcnt, len, result)   ((void)(result))
+#endif
+
+#ifdef RS485_USING_RX_RING
+#if (RS485_RX_RING_SIZE & (RS485_RX_RING_SIZE - 1)) != 0
+#error "RS485_RX_RING_SIZE must be power of 2"
+#endif
+#ifndef rt_hw_dmb               //cpu port without it, a single core which does not reorder memory accesses
+#define rt_hw_dmb()
+#endif
+#ifdef __GNUC__
+#define RS485_RING_BARRIER()    do { __asm volatile ("" ::: "memory"); rt_hw_dmb(); } while (0)
+#else
+#define RS485_RING_BARRIER()    rt_hw_dmb()
+#endif
+#endif
+
+#ifdef RS485_USING_SERIAL_V2
+#ifndef RT_SERIAL_CTRL_SET_RX_TIMEOUT
+#error "RS485_USING_SERIAL_V2 needs serial framework v2 with receive timeout control, RT_USING_SERIAL_V2"
+#endif
+#ifdef RS485_USING_RX_RING
+#error "RS485_USING_RX_RING is not used with RS485_USING_SERIAL_V2, the serial v2 driver buffers receive"
+#endif
+#endif
+
+#ifdef RS485_USING_FRAME_HANDLER
+#define RS485_LOOP_BITS     31          //event bits shared by instances of a loop
+#define RS485_LOOP_EVT_WAKE (1UL << 31) //instances or timers of loop changed
+
+/* default event loop of rs485_set_frame_handler, started at the first use */
+static struct rs485_worker
+{
+    rt_uint8_t state;       //0--not started, 1--starting, 2--running
+    rs485_loop_t loop;
+    rt_uint8_t stack[RS485_WORKER_STACK_SIZE];
+} rs485_worker = {0};
+#endif
+
+#ifdef RS485_USING_DWT_CLOCK
+#define RS485_DEMCR         (*(volatile rt_uint32_t *)0xE000EDFC)
+#define RS485_DWT_CTRL      (*(volatile rt_uint32_t *)0xE0001000)
+#define RS485_DWT_CYCCNT    (*(volatile rt_uint32_t *)0xE0001004)
+
+extern rt_uint32_t SystemCoreClock;
+
+/* 
+ * @brief   get free running microsecond counter from the cortex-m cycle counter
+ * @retval  microseconds
+ */
+rt_uint32_t rs485_get_us(void)
+{
+    static rt_uint32_t last_cyc = 0;
+    static rt_uint32_t rem_cyc = 0;
+    static rt_uint32_t us = 0;
+    rt_uint32_t cyc_per_us = SystemCoreClock / 1000000;
+    rt_uint32_t now;
+    rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if ((RS485_DWT_CTRL & 0x01) == 0)
+    {
+        RS485_DEMCR |= (1UL << 24);//TRCENA
+        RS485_DWT_CYCCNT = 0;
+        RS485_DWT_CTRL |= 0x01;//CYCCNTENA
+        last_cyc = 0;
+    }
+    now = RS485_DWT_CYCCNT;
+    rem_cyc += now - last_cyc;
+    last_cyc = now;
+    us += rem_cyc / cyc_per_us;
+    rem_cyc %= cyc_per_us;
+    now = us;
+    rt_hw_interrupt_enable(level);
+    
+    return(now);
+}
+#else
+/* 
+ * @brief   get free running microsecond counter, tick resolution by default.
+ *          board can override it with a hardware timer or cycle counter.
+ * @retval  microseconds
+ */
+RT_WEAK rt_uint32_t rs485_get_us(void)
+{
+    return(rt_tick_get() * RS485_TICK_US);
+}
+#endif
+
+#ifdef RS485_USING_STATS
+/* account latency of an answered transaction */
+static void rs485_stat_xfer(rs485_inst_t * hinst, rt_uint32_t start)
+{
+    rt_uint32_t us = rs485_get_us() - start;
+    
+    if (hinst->stats.xfer_count == 0 || us < hinst->stats.xfer_min_us)
+    {
+        hinst->stats.xfer_min_us = us;
+    }
+    if (us > hinst->stats.xfer_max_us)
+    {
+        hinst->stats.xfer_max_us = us;
+    }
+    hinst->stats.xfer_sum_us += us;
+    hinst->stats.xfer_count++;
+}
+#endif
+
+#ifdef RS485_USING_TRACE
+/* record an entry in trace ring, a slot is reserved by a short interrupt disabled increment, 
+   so senders, receivers and the transmit completion record without lock, the copy is bounded by RS485_TRACE_DATA */
+static void rs485_trace_put(rs485_inst_t * hinst, rt_uint8_t dir, const rs485_iovec_t *iov, int iovcnt, int len, int result)
 {
-    rt_device_t serial;     //serial device handle
-    rt_mutex_t lock;        //mutex handle
-    rt_event_t evt;         //event handle
-    rt_uint8_t status;      //connect status
-    rt_uint8_t level;       //control pin send mode level, 0--low, 1--high
-    rt_int16_t pin;         //control pin number used, -1--no using
-    rt_int32_t timeout;     //receive block timeout, ms   
-    rt_int32_t byte_tmo;    //receive byte interval timeout, ms
+    struct rs485_trace *t;
+    rt_base_t level;
+    int cnt = 0;
+    
+    level = rt_hw_interrupt_disable();
+    t = &hinst->trace[hinst->trace_head & (RS485_TRACE_NUM - 1)];
+    hinst->trace_head++;
+    rt_hw_interrupt_enable(level);
+    
+    t->stamp = rs485_get_us();
+    t->dir = dir;
+    t->len = len;
+    t->result = result;
+    for (int i = 0; i < iovcnt && cnt < len && cnt < RS485_TRACE_DATA; i++)
+    {
+        int n = iov[i].len;
+        if (n > len - cnt)
+        {
+            n = len - cnt;
+        }
+        if (n > RS485_TRACE_DATA - cnt)
+        {
+            n = RS485_TRACE_DATA - cnt;
+        }
+        rt_memcpy(t->data + cnt, iov[i].base, n);
+        cnt += n;
+    }
+    t->cnt = cnt;
+}
+#endif
+
+/* take bus lock up to tmo ticks, the wait is accounted in stats */
+static rt_err_t rs485_bus_take_tmo(rs485_inst_t * hinst, rt_int32_t tmo)
+{
+#ifdef RS485_USING_STATS
+    rt_uint32_t start = rs485_get_us();
+    rt_uint32_t us;
+    rt_err_t rc;
+    
+    rc = rt_mutex_take(&hinst->lock, tmo);
+    if (rc != RT_EOK)
+    {
+        return(rc);
+    }
+    us = rs485_get_us() - start;
+    if (us > hinst->stats.lock_wait_max_us)
+    {
+        hinst->stats.lock_wait_max_us = us;
+    }
+    hinst->stats.lock_wait_us += us;
+    hinst->stats.lock_takes++;
+    
+    return(RT_EOK);
+#else
+    return(rt_mutex_take(&hinst->lock, tmo));
+#endif
+}
+
+/* take bus lock, the wait is accounted in stats */
+static rt_err_t rs485_bus_take(rs485_inst_t * hinst)
+{
+    return(rs485_bus_take_tmo(hinst, RT_WAITING_FOREVER));
+}
+
+/* limits of a blocking call, it is cancelled by rs485_cancel called after its start */
+struct rs485_wait
+{
+    rt_uint32_t seq;        //cancel sequence at the start of call
+    rt_uint8_t bounded;     //the deadline is valid
+    rt_tick_t deadline;     //tick the call ends at
+    rt_uint8_t crc_type;    //crc type of receive in call
+    rt_uint32_t crc;        //running crc of the frame received in call
 };
 
-static rt_err_t rs485_recv_ind_hook(rt_device_t dev, rt_size_t size)
+static void rs485_wait_init(rs485_inst_t * hinst, struct rs485_wait *w, int bounded, rt_tick_t deadline)
+{
+    w->seq = hinst->cancel_seq;
+    w->bounded = (bounded != 0);
+    w->deadline = deadline;
+    w->crc_type = hinst->rx_crc_type;
+    w->crc = 0;
+}
+
+/* wait of tmo ticks shortened to the deadline of call, 0--the deadline passed */
+static rt_int32_t rs485_wait_left(const struct rs485_wait *w, rt_int32_t tmo)
+{
+    rt_int32_t left;
+    
+    if ( ! w->bounded)
+    {
+        return(tmo);
+    }
+    
+    left = (rt_int32_t)(w->deadline - rt_tick_get());
+    if (left <= 0)
+    {
+        return(0);
+    }
+    if (tmo < 0 || tmo > left)
+    {
+        return(left);
+    }
+    
+    return(tmo);
+}
+
+/* the call is cancelled, the wakeup is passed on, since one waiter may clear it before another waits */
+static int rs485_cancelled(rs485_inst_t * hinst, const struct rs485_wait *w)
+{
+    if (hinst->cancel_seq == w->seq)
+    {
+        return(0);
+    }
+    
+#ifndef RS485_USING_SERIAL_V2
+    rt_event_send(&hinst->evt, RS485_EVT_CANCEL);
+#endif
+    
+    return(1);
+}
+
+/* take bus lock within the limits of call, -RT_ETIMEOUT--the deadline passed, -RT_EINTR--cancelled */
+static rt_err_t rs485_bus_wait(rs485_inst_t * hinst, const struct rs485_wait *w)
+{
+    rt_int32_t tmo = rs485_wait_left(w, RT_WAITING_FOREVER);
+    rt_err_t rc;
+    
+    if (tmo == 0)
+    {
+        return(-RT_ETIMEOUT);
+    }
+    
+    rc = rs485_bus_take_tmo(hinst, tmo);
+    if (rc != RT_EOK)
+    {
+        return(rc);
+    }
+    
+    if (rs485_cancelled(hinst, w))//the holder was cancelled too and released it
+    {
+        rt_mutex_release(&hinst->lock);
+        return(-RT_EINTR);
+    }
+    
+    return(RT_EOK);
+}
+
+#ifdef RS485_USING_RX_RING
+/* move received datas from serial into ring, called by receive indication only, so it is the single producer.
+   a barrier keeps the writes of datas after the read of tail, and another one before the head is published.
+   datas beyond the ring are dropped, a waiting receiver is woken up by the first ones */
+static void rs485_ring_fill(rs485_inst_t * hinst)
+{
+    rt_uint32_t head = hinst->ring_head;
+    rt_uint8_t drop[16];
+    
+    while (1)
+    {
+        rt_uint32_t pos = head & (RS485_RX_RING_SIZE - 1);
+        rt_uint32_t len = RS485_RX_RING_SIZE - (head - hinst->ring_tail);
+        int n;
+        if (len == 0)//ring full
+        {
+            while ((n = rt_device_read(hinst->serial, 0, drop, sizeof(drop))) > 0)
+            {
+                RS485_STAT_ADD(hinst, rx_drops, n);
+            }
+            break;
+        }
+        if (len > RS485_RX_RING_SIZE - pos)
+        {
+            len = RS485_RX_RING_SIZE - pos;
+        }
+        RS485_RING_BARRIER();//the receiver finished reading the space it freed
+        n = rt_device_read(hinst->serial, 0, &hinst->ring[pos], len);
+        if (n <= 0)
+        {
+            break;
+        }
+        head += n;
+        RS485_RING_BARRIER();//datas are visible before the head
+        hinst->ring_head = head;
+        if (n < len)
+        {
+            break;
+        }
+    }
+}
+#endif
+
+static rt_err_t rs485_recv_ind_hook(rt_device_t dev, rt_size_t size)
+{
+    rs485_inst_t *hinst = (rs485_inst_t *)(dev->user_data);
+    hinst->rx_stamp = rs485_get_us();
+#ifdef RS485_USING_RTO
+    if (hinst->rx_first_wait)//the response starts, later indications do not move it
+    {
+        hinst->rx_first = hinst->rx_stamp;
+        hinst->rx_first_wait = 0;
+    }
+#endif
+#ifdef RS485_USING_RX_RING
+    rs485_ring_fill(hinst);
+#endif
+#ifndef RS485_USING_SERIAL_V2
+    if (hinst->alloc)
+    {
+        rt_event_send(&hinst->evt, RS485_EVT_RX_IND);
+    }
+#endif
+#ifdef RS485_USING_FRAME_HANDLER
+    {
+        rs485_loop_t *loop = hinst->loop;//read once, it is cleared by removal
+        if (loop != RT_NULL)
+        {
+            rt_event_send(&loop->evt, hinst->loop_bit);
+        }
+    }
+#endif
+    return(RT_EOK);
+}
+
+#ifndef RS485_USING_SERIAL_V2
+/* asynchronous transmit left the wire, release the bus to receive and notify */
+static void rs485_send_finish(void *args)
+{
+    rs485_inst_t *hinst = (rs485_inst_t *)args;
+    
+    if (RS485_PIN_CTRL(hinst))
+    {
+        rt_pin_write(hinst->pin, ! hinst->level);
+        RS485_STAT_ADD(hinst, mode_switches, 1);
+    }
+    hinst->tx_busy = 0;
+    if (hinst->tx_cb)
+    {
+        hinst->tx_cb(hinst, hinst->tx_len, hinst->tx_ctx);
+    }
+    rt_event_send(&hinst->evt, RS485_EVT_TX_DONE);
+}
+
+static rt_err_t rs485_send_cpl_hook(rt_device_t dev, void *buffer)
+{
+    rs485_inst_t *hinst = (rs485_inst_t *)(dev->user_data);
+    
+    if (hinst->alloc == 0)
+    {
+        return(RT_EOK);
+    }
+    
+    if ( ! hinst->tx_busy)//synchronous transmit waits the event
+    {
+        hinst->tx_cpl_cnt++;
+        rt_event_send(&hinst->evt, RS485_EVT_TX_CPL);
+        return(RT_EOK);
+    }
+    
+    //the last character is still in the shift register
+    if ( ! RS485_PIN_CTRL(hinst) || (hinst->sw_post_us <= RS485_TX_SPIN_US_MAX))
+    {
+        if (RS485_PIN_CTRL(hinst) && hinst->sw_post_us)
+        {
+            rt_hw_us_delay(hinst->sw_post_us);
+        }
+        rs485_send_finish(hinst);
+    }
+    else
+    {
+        rt_tick_t tick = hinst->sw_post_us / RS485_TICK_US + 1;
+        rt_timer_control(&hinst->tx_timer, RT_TIMER_CTRL_SET_TIME, &tick);
+        rt_timer_start(&hinst->tx_timer);
+    }
+    
+    return(RT_EOK);
+}
+#endif
+
+static rt_uint32_t rs485_cal_char_us(int baudrate, int databits, int parity, int stopbits)
+{
+    int bits = 1 + databits + (parity != 0) + (stopbits ? 2 : 1);//start + data + parity + stop
+    return((bits * 1000000 + baudrate - 1) / baudrate);
+}
+
+static rt_uint32_t rs485_cal_byte_tmo(rt_uint32_t char_us)
+{
+    rt_uint32_t tmo = char_us * RS485_BYTE_TMO_CHARS / 10;
+    if (tmo < RS485_BYTE_TMO_US_MIN)
+    {
+        tmo = RS485_BYTE_TMO_US_MIN;
+    }
+    else if (tmo > RS485_BYTE_TMO_MAX * 1000)
+    {
+        tmo = RS485_BYTE_TMO_MAX * 1000;
+    }
+    return (tmo);
+}
+
+#if !defined(RS485_USING_SERIAL_V2) || defined(RS485_USING_FRAME_HANDLER)
+/* frame gap at the resolution of rs485_get_us, the stamps of tick clock are whole ticks and one may be taken
+   at the end of its tick, so the gap is rounded up to whole ticks and one tick more */
+static rt_uint32_t rs485_gap_us(rs485_inst_t * hinst)
+{
+#ifdef RS485_USING_US_CLOCK
+    return(hinst->byte_tmo);
+#else
+    return(((hinst->byte_tmo + RS485_TICK_US - 1) / RS485_TICK_US + 1) * RS485_TICK_US);
+#endif
+}
+#endif
+
+#ifndef RS485_USING_SERIAL_V2
+/* wait the rest of frame gap up to the deadline of call, returns RT_EOK when datas may have arrived, 
+   the call is cancelled or the deadline passed, -RT_ETIMEOUT when the gap elapsed.
+   only a rest up to RS485_GAP_SPIN_US_MAX is spun, a few characters of high baudrate, a longer one sleeps */
+static int rs485_wait_gap(rs485_inst_t * hinst, const struct rs485_wait *w)
+{
+    rt_uint32_t recved = 0;
+    rt_uint32_t gap = rs485_gap_us(hinst);
+    rt_uint32_t elapsed = rs485_get_us() - hinst->rx_stamp;
+    rt_uint32_t left;
+    rt_int32_t tmo;
+    
+    if (elapsed >= gap)
+    {
+        return(-RT_ETIMEOUT);
+    }
+    
+    left = gap - elapsed;
+    if (left <= RS485_GAP_SPIN_US_MAX)
+    {
+        rt_hw_us_delay(left);
+        return(RT_EOK);
+    }
+    
+    tmo = rs485_wait_left(w, (left + RS485_TICK_US - 1) / RS485_TICK_US);//new datas or cancel wake up early
+    if (tmo > 0)
+    {
+        rt_event_recv(&hinst->evt, (RS485_EVT_RX_IND | RS485_EVT_CANCEL), (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), 
+                        tmo, &recved);
+    }
+    
+    return(RT_EOK);
+}
+#endif
+
+/* ticks left of a timeout started at start tick */
+static rt_int32_t rs485_tmo_left(rt_tick_t start, rt_int32_t timeout)
+{
+    rt_tick_t used;
+    
+    if (timeout < 0)
+    {
+        return(RT_WAITING_FOREVER);
+    }
+    
+    used = rt_tick_get() - start;
+    if (used >= (rt_tick_t)timeout)
+    {
+        return(0);
+    }
+    
+    return(timeout - used);
+}
+
+static void rs485_rx_crc_reset(int type, rt_uint32_t *crc)
+{
+    *crc = (type == RS485_CRC_16) ? RS485_CRC16_INIT : RS485_CRC32_INIT;
+}
+
+/* update running crc over each chunk as it is read, so the frame is checked when the gap elapses */
+static void rs485_rx_crc_update(int type, rt_uint32_t *crc, const void *buf, int len)
+{
+    if (type != RS485_CRC_NONE)
+    {
+        *crc = rs485_crc_update(type, *crc, buf, len);
+    }
+}
+
+#ifdef RS485_USING_RX_RING
+/* take datas from ring with bus lock held, receivers are serialized by it, so it is the single consumer.
+   the head is the sequence of receive indications, a receiver finding it equal to the tail waits the event 
+   sent after the head is updated, so a wakeup is never lost, and no serial read is needed to find it empty.
+   barriers keep the reads of datas between the read of head and the publish of tail */
+static int rs485_ring_read(rs485_inst_t * hinst, void *buf, int size)
+{
+    rt_uint32_t tail = hinst->ring_tail;
+    rt_uint32_t avail = hinst->ring_head - tail;
+    rt_uint32_t pos = tail & (RS485_RX_RING_SIZE - 1);
+    rt_uint32_t len;
+    
+    if (avail == 0)
+    {
+        return(0);
+    }
+    if ((rt_uint32_t)size > avail)
+    {
+        size = avail;
+    }
+    RS485_RING_BARRIER();//datas published with the head are visible
+    len = RS485_RX_RING_SIZE - pos;
+    if (len > (rt_uint32_t)size)
+    {
+        len = size;
+    }
+    rt_memcpy(buf, &hinst->ring[pos], len);
+    if (len < (rt_uint32_t)size)//wrapped
+    {
+        rt_memcpy((rt_uint8_t *)buf + len, hinst->ring, size - len);
+    }
+    RS485_RING_BARRIER();//datas are read out before the space is freed
+    hinst->ring_tail = tail + size;
+    
+    return(size);
+}
+#endif
+
+#ifdef RS485_USING_SERIAL_V2
+/* set receive timeout of blocking read of serial v2 driver, ticks, 0--no wait, the control is issued when it changes */
+static void rs485_v2_rx_tmo(rs485_inst_t * hinst, rt_int32_t tmo)
+{
+    if (hinst->rx_tmo_set != tmo)
+    {
+        rt_device_control(hinst->serial, RT_SERIAL_CTRL_SET_RX_TIMEOUT, &tmo);
+        hinst->rx_tmo_set = tmo;
+    }
+}
+
+/* read datas buffered by serial v2 driver without waiting */
+static int rs485_v2_read(rs485_inst_t * hinst, void *buf, int size)
+{
+    int len;
+    
+    rs485_v2_rx_tmo(hinst, 0);
+    len = rt_device_read(hinst->serial, 0, buf, size);
+    
+    return(len > 0 ? len : 0);
+}
+
+/* wait of first byte shortened to a slice, so cancel, break and deadline are seen in time */
+static rt_int32_t rs485_v2_slice(rt_int32_t tmo)
+{
+    rt_int32_t slice = rt_tick_from_millisecond(RS485_SERIAL_V2_SLICE);
+    
+    if (slice <= 0)
+    {
+        slice = 1;
+    }
+    
+    return((tmo < 0 || tmo > slice) ? slice : tmo);
+}
+
+/* frame gap as receive timeout of driver, whole ticks, one more since a wait of n ticks may end after n-1 */
+static rt_int32_t rs485_v2_gap(rs485_inst_t * hinst)
+{
+    return((hinst->byte_tmo + RS485_TICK_US - 1) / RS485_TICK_US + 1);
+}
+
+/* wait datas in the blocking read of serial v2 driver up to tmo ticks, the byte read is kept for next read,
+   returns RT_EOK when datas arrived or the deadline passed (tmo is 0), -RT_ETIMEOUT when nothing arrived */
+static int rs485_v2_wait(rs485_inst_t * hinst, rt_int32_t tmo)
+{
+    if (tmo == 0 || hinst->keep_len)
+    {
+        return(RT_EOK);
+    }
+    
+    rs485_v2_rx_tmo(hinst, tmo);
+    if (rt_device_read(hinst->serial, 0, hinst->keep_buf, 1) != 1)
+    {
+        return(-RT_ETIMEOUT);
+    }
+    hinst->rx_stamp = rs485_get_us();
+    hinst->keep_pos = 0;
+    hinst->keep_len = 1;
+    
+    return(RT_EOK);
+}
+#endif
+
+/* read received datas, the kept datas are read out before the serial, they are not mixed in one read */
+static int rs485_rx_read(rs485_inst_t * hinst, void *buf, int size)
+{
+    if (hinst->keep_len == 0)
+    {
+#ifdef RS485_USING_RX_RING
+        return(rs485_ring_read(hinst, buf, size));
+#elif defined(RS485_USING_SERIAL_V2)
+        return(rs485_v2_read(hinst, buf, size));
+#else
+        return(rt_device_read(hinst->serial, 0, buf, size));
+#endif
+    }
+    
+    if (size > hinst->keep_len)
+    {
+        size = hinst->keep_len;
+    }
+    rt_memcpy(buf, hinst->keep_buf + hinst->keep_pos, size);
+    hinst->keep_pos += size;
+    hinst->keep_len -= size;
+    if (hinst->keep_len == 0)
+    {
+        hinst->keep_pos = 0;
+    }
+    
+    return(size);
+}
+
+/* put datas received after the end of frame back in front of the kept datas, 
+   they are less than a chunk, so they always fit */
+static void rs485_rx_keep(rs485_inst_t * hinst, const void *buf, int len)
+{
+    if (hinst->keep_pos < len)
+    {
+        rt_memmove(hinst->keep_buf + len, hinst->keep_buf + hinst->keep_pos, hinst->keep_len);
+        hinst->keep_pos = len;
+    }
+    hinst->keep_pos -= len;
+    hinst->keep_len += len;
+    rt_memcpy(hinst->keep_buf + hinst->keep_pos, buf, len);
+}
+
+/* receive one frame into segments with bus lock held: wait the first byte up to timeout, 
+   then read until the segments are filled, the frame gap elapses or the predicate reports the frame completed.
+   the predicate sees the datas held in the first segment only, a frame length beyond them is read up to,
+   datas after the frame end it returns are kept for next receive, so chunks are limited to the keep buffer 
+   while a predicate is given.
+   the deadline of call shortens the wait of first byte, and it ends a frame still arriving with -RT_ETIMEOUT,
+   so a chattering device can not extend the call, a cancel ends any wait with -RT_EINTR */
+static int rs485_recv_segs(rs485_inst_t * hinst, const rs485_iovec_t *iov, int iovcnt, rt_int32_t timeout,
+                            rs485_frame_done_t done, void *ctx, struct rs485_wait *w)
+{
+    int result = RT_EOK;
+    int recv_len = 0;
+    int seg = 0;
+    int pos = 0;
+    int want = 0;//frame length reported beyond the received datas
+#ifndef RS485_USING_SERIAL_V2
+    rt_uint32_t recved = 0;
+#endif
+    rt_tick_t start = rt_tick_get();
+    
+    rs485_rx_crc_reset(w->crc_type, &w->crc);
+    
+    while(seg < iovcnt)
+    {
+        rt_int32_t tmo;
+        int len;
+        if (pos >= iov[seg].len)//segment filled
+        {
+            seg++;
+            pos = 0;
+            continue;
+        }
+        len = iov[seg].len - pos;
+        if (done != RT_NULL && len > RS485_RX_KEEP_SIZE)
+        {
+            len = RS485_RX_KEEP_SIZE;
+        }
+        if (want > 0 && len > want - recv_len)//no datas of next frame are read
+        {
+            len = want - recv_len;
+        }
+        len = rs485_rx_read(hinst, (char *)iov[seg].base + pos, len);
+        if (len)
+        {
+            char *chunk = (char *)iov[seg].base + pos;
+            int end;
+#ifdef RS485_USING_RTO
+            if (recv_len == 0 && hinst->rx_first_wait)//the datas were not indicated, as a blocking read of v2
+            {
+                hinst->rx_first = hinst->rx_stamp;
+                hinst->rx_first_wait = 0;
+            }
+#endif
+            recv_len += len;
+            pos += len;
+            if (want > 0)
+            {
+                rs485_rx_crc_update(w->crc_type, &w->crc, chunk, len);
+                if (recv_len >= want)
+                {
+                    break;
+                }
+                continue;
+            }
+            end = 0;
+            if (done != RT_NULL)
+            {
+                end = done((const rt_uint8_t *)iov[0].base, (recv_len < iov[0].len) ? recv_len : iov[0].len, ctx);
+            }
+            if (end > recv_len)//the frame ends beyond the received datas
+            {
+                want = end;
+                end = 0;
+            }
+            if (end > 0 && end < recv_len - len)//the frame ended in an earlier chunk
+            {
+                end = recv_len - len;
+            }
+            if (end > 0 && end < recv_len)//datas after the frame end belong to next frame
+            {
+                rs485_rx_keep(hinst, chunk + len - (recv_len - end), recv_len - end);
+                len -= recv_len - end;
+                recv_len = end;
+            }
+            rs485_rx_crc_update(w->crc_type, &w->crc, chunk, len);
+            if (end > 0)
+            {
+                break;
+            }
+            continue;
+        }
+        if (rs485_cancelled(hinst, w))
+        {
+            result = -RT_EINTR;
+            break;
+        }
+        if (recv_len)
+        {
+            if (w->bounded && rs485_wait_left(w, RT_WAITING_FOREVER) == 0)//the frame is still arriving
+            {
+                result = -RT_ETIMEOUT;
+                break;
+            }
+#ifdef RS485_USING_SERIAL_V2
+            if (rs485_v2_wait(hinst, rs485_wait_left(w, rs485_v2_gap(hinst))) != RT_EOK)//the gap is timed by driver
+#else
+            if ((hinst->flags & RS485_CONN_IDLE_END) || (rs485_wait_gap(hinst, w) != RT_EOK))
+#endif
+            {
+                RS485_STAT_ADD(hinst, rx_gap_ends, 1);//or the idle line of dma receive ended the frame
+                break;
+            }
+            continue;
+        }
+        tmo = rs485_wait_left(w, rs485_tmo_left(start, timeout));
+        if (tmo == 0)
+        {
+            if (timeout != 0)//a poll of zero timeout is not a timeout
+            {
+                RS485_STAT_ADD(hinst, rx_timeouts, 1);
+                RS485_TRACE(hinst, RS485_TRACE_RX, RT_NULL, 0, 0, -RT_ETIMEOUT);
+            }
+            break;
+        }
+#ifdef RS485_USING_SERIAL_V2
+        rs485_v2_wait(hinst, rs485_v2_slice(tmo));//the timeout is checked above after each slice
+#else
+        if (rt_event_recv(&hinst->evt, (RS485_EVT_RX_IND | RS485_EVT_CANCEL), (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), 
+                tmo, &recved) != RT_EOK)
+        {
+            RS485_STAT_ADD(hinst, rx_timeouts, 1);
+            RS485_TRACE(hinst, RS485_TRACE_RX, RT_NULL, 0, 0, -RT_ETIMEOUT);
+            break;
+        }
+#endif
+    }
+    hinst->rx_crc = w->crc;//for rs485_get_rx_crc, while the receive lock is held
+    
+    if (result != RT_EOK)//the datas of an unfinished frame are dropped
+    {
+        if (result == -RT_EINTR)
+        {
+            RS485_STAT_ADD(hinst, rx_breaks, 1);
+        }
+        else
+        {
+            RS485_STAT_ADD(hinst, rx_timeouts, 1);
+        }
+        RS485_TRACE(hinst, RS485_TRACE_RX, iov, iovcnt, recv_len, result);
+        return(result);
+    }
+    
+    if (recv_len)
+    {
+        RS485_STAT_ADD(hinst, rx_bytes, recv_len);
+        RS485_STAT_ADD(hinst, rx_frames, 1);
+        RS485_TRACE(hinst, RS485_TRACE_RX, iov, iovcnt, recv_len, RT_EOK);
+    }
+    
+    return(recv_len);
+}
+
+/* delimiter scan state, datas before scanned position have no delimiter start */
+struct rs485_delim
+{
+    const rt_uint8_t *delim;
+    int dlen;
+    int scanned;
+};
+
+/* frame is completed at the end of delimiter, each byte is scanned once by memchr */
+static int rs485_delim_done(const rt_uint8_t *buf, int len, void *ctx)
+{
+    struct rs485_delim *d = (struct rs485_delim *)ctx;
+    int pos = d->scanned;
+    
+    while (pos + d->dlen <= len)
+    {
+        const rt_uint8_t *p = memchr(buf + pos, d->delim[0], len - d->dlen + 1 - pos);
+        if (p == RT_NULL)
+        {
+            pos = len - d->dlen + 1;
+            break;
+        }
+        pos = p - buf;
+        if (memcmp(p, d->delim, d->dlen) == 0)
+        {
+            return(pos + d->dlen);
+        }
+        pos++;
+    }
+    d->scanned = pos;
+    
+    return(0);
+}
+
+static int rs485_recv_datas(rs485_inst_t * hinst, void *buf, int size, rt_int32_t timeout,
+                            rs485_frame_done_t done, void *ctx, struct rs485_wait *w)
+{
+    rs485_iovec_t iov;
+    
+    iov.base = buf;
+    iov.len = size;
+    
+    return(rs485_recv_segs(hinst, &iov, 1, timeout, done, ctx, w));
+}
+
+/* receive one frame with receive lock held, the bus lock is only taken while datas are arriving,
+   so a transmit preempts the wait of first byte and the wait resumes after it */
+static int rs485_recv_idle(rs485_inst_t * hinst, void *buf, int size, rs485_frame_done_t done, void *ctx,
+                            rt_int32_t timeout, struct rs485_wait *w)
+{
+    int recv_len = 0;
+    rt_tick_t start = rt_tick_get();
+#ifdef RS485_USING_SERIAL_V2
+    rt_uint32_t brk = hinst->break_seq;//breaks before the call are stale
+#else
+    rt_uint32_t recved = 0;
+    
+    rt_event_recv(&hinst->evt, RS485_EVT_RX_BREAK, (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), 0, &recved);//drop stale break
+#endif
+    
+    while (1)
+    {
+        rt_int32_t tmo;
+        
+        if (hinst->status == 0)
+        {
+            return(-RT_ERROR);
+        }
+        recv_len = rs485_bus_wait(hinst, w);
+        if (recv_len == -RT_EINTR)
+        {
+            RS485_STAT_ADD(hinst, rx_breaks, 1);
+            RS485_TRACE(hinst, RS485_TRACE_RX, RT_NULL, 0, 0, -RT_EINTR);
+            break;
+        }
+        if (recv_len == -RT_ETIMEOUT)//the deadline passed before a frame started
+        {
+            RS485_STAT_ADD(hinst, rx_timeouts, 1);
+            RS485_TRACE(hinst, RS485_TRACE_RX, RT_NULL, 0, 0, -RT_ETIMEOUT);
+            recv_len = 0;
+            break;
+        }
+        if (recv_len != RT_EOK)
+        {
+            return(-RT_ERROR);
+        }
+        recv_len = rs485_recv_datas(hinst, buf, size, 0, done, ctx, w);
+#ifdef RS485_USING_SERIAL_V2
+        if (recv_len == 0)//datas are waited in the driver with bus held, a slice at a time so transmits get in
+        {
+            tmo = rs485_wait_left(w, rs485_tmo_left(start, timeout));
+            if ((tmo != 0) && (rs485_v2_wait(hinst, rs485_v2_slice(tmo)) == RT_EOK))
+            {
+                recv_len = rs485_recv_datas(hinst, buf, size, 0, done, ctx, w);
+            }
+        }
+#endif
+        rt_mutex_release(&hinst->lock);
+        if (recv_len != 0)
+        {
+            break;
+        }
+        
+        tmo = rs485_wait_left(w, rs485_tmo_left(start, timeout));
+        if (tmo == 0)
+        {
+            RS485_STAT_ADD(hinst, rx_timeouts, 1);
+            RS485_TRACE(hinst, RS485_TRACE_RX, RT_NULL, 0, 0, -RT_ETIMEOUT);
+            break;
+        }
+#ifdef RS485_USING_SERIAL_V2
+        if (hinst->break_seq != brk)
+        {
+            RS485_STAT_ADD(hinst, rx_breaks, 1);
+            RS485_TRACE(hinst, RS485_TRACE_RX, RT_NULL, 0, 0, -RT_EINTR);
+            break;
+        }
+#else
+        recved = 0;
+        if (rt_event_recv(&hinst->evt, (RS485_EVT_RX_IND | RS485_EVT_RX_BREAK | RS485_EVT_CANCEL), 
+                (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), tmo, &recved) != RT_EOK)
+        {
+            RS485_STAT_ADD(hinst, rx_timeouts, 1);
+            RS485_TRACE(hinst, RS485_TRACE_RX, RT_NULL, 0, 0, -RT_ETIMEOUT);
+            break;
+        }
+        if ((recved & RS485_EVT_RX_BREAK) != 0)
+        {
+            RS485_STAT_ADD(hinst, rx_breaks, 1);
+            RS485_TRACE(hinst, RS485_TRACE_RX, RT_NULL, 0, 0, -RT_EINTR);
+            break;
+        }
+#endif
+    }
+    
+    return(recv_len);
+}
+
+static void rs485_mode_set(rs485_inst_t * hinst, int mode)//mode : 0--receive mode, 1--send mode
+{
+    if ( ! RS485_PIN_CTRL(hinst))//no pin, or the uart switches the transceiver
+    {
+        return;
+    }
+    
+    RS485_STAT_ADD(hinst, mode_switches, 1);
+    if (mode)
+    {
+        rt_pin_write(hinst->pin, hinst->level);
+        if (hinst->sw_pre_us)//transceiver enable time
+        {
+            rt_hw_us_delay(hinst->sw_pre_us);
+        }
+    }
+    else
+    {
+        if (hinst->sw_post_us)//the last character is still shifting out
+        {
+            rt_hw_us_delay(hinst->sw_post_us);
+        }
+        rt_pin_write(hinst->pin, ! hinst->level);
+    }
+}
+
+/* request the uart to drive transceiver enable or release it, RT_EOK when the driver applied it */
+static int rs485_hw_de_set(rs485_inst_t * hinst, int enable)
+{
+    struct rs485_hw_de de;
+    
+    de.enable = enable;
+    de.level = hinst->level;
+    de.ack = 0;
+    de.pre_us = hinst->sw_pre_us;
+    de.post_us = hinst->sw_post_auto ? 0 : hinst->sw_post_us;//no drain delay, the uart deasserts after the stop bit
+    if ((rt_device_control(hinst->serial, RS485_CTRL_HW_DE, &de) != RT_EOK) || (de.ack == 0))
+    {
+        return(-RT_ENOSYS);
+    }
+    
+    return(RT_EOK);
+}
+
+/* wait asynchronous transmit completed up to timeout ticks, and within the limits of call when w is given,
+   -RT_ETIMEOUT--the timeout or the deadline passed, -RT_EINTR--cancelled */
+static int rs485_tx_wait(rs485_inst_t * hinst, rt_int32_t timeout, const struct rs485_wait *w)
+{
+#ifdef RS485_USING_SERIAL_V2
+    return(RT_EOK);//no asynchronous transmit, writes of serial v2 block until datas are sent
+#else
+    rt_uint32_t recved = 0;
+    rt_tick_t start = rt_tick_get();
+    
+    while (hinst->tx_busy)
+    {
+        rt_int32_t tmo = rs485_tmo_left(start, timeout);
+        if (w != RT_NULL)
+        {
+            if (rs485_cancelled(hinst, w))
+            {
+                return(-RT_EINTR);
+            }
+            tmo = rs485_wait_left(w, tmo);
+        }
+        if (tmo == 0)
+        {
+            return(-RT_ETIMEOUT);
+        }
+        rt_event_recv(&hinst->evt, (RS485_EVT_TX_DONE | RS485_EVT_CANCEL), (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), 
+                        tmo, &recved);
+    }
+    
+    return(RT_EOK);
+#endif
+}
+
+/* wait the asynchronous transmit owning the bus for the wire time of its datas, within the limits of call 
+   when w is given, a transmit whose completion is lost by then is aborted, so the bus is not held forever.
+   -RT_ETIMEOUT--the deadline passed, -RT_EINTR--cancelled */
+static int rs485_tx_drain(rs485_inst_t * hinst, const struct rs485_wait *w)
+{
+#ifdef RS485_USING_SERIAL_V2
+    return(RT_EOK);
+#else
+    rt_int32_t tmo = rt_tick_from_millisecond((hinst->tx_len * hinst->char_us) / 1000 + 10);
+    int rc = rs485_tx_wait(hinst, tmo, w);
+    
+    if (rc == -RT_ETIMEOUT && (w == RT_NULL || rs485_wait_left(w, RT_WAITING_FOREVER) != 0))//not the deadline
+    {
+        LOG_W("rs485 asynchronous transmit is not completed, it is aborted.");
+        rt_timer_stop(&hinst->tx_timer);
+        hinst->tx_busy = 0;
+        rc = RT_EOK;
+    }
+    
+    return(rc);
+#endif
+}
+
+/* write segments back to back with bus lock held, the bus is released when the last stop bit left the wire.
+   an asynchronous transmit is waited within the limits of call first, -RT_ETIMEOUT--the deadline passed, 
+   -RT_EINTR--cancelled before any datas are written */
+static int rs485_send_segs(rs485_inst_t * hinst, const rs485_iovec_t *iov, int iovcnt, const struct rs485_wait *w)
+{
+    int send_len = 0;
+    int segs = 0;
+    int result = RT_EOK;
+#ifndef RS485_USING_SERIAL_V2
+    rt_uint32_t recved = 0;
+#endif
+    
+    result = rs485_tx_drain(hinst, w);//the bus is owned by asynchronous transmit
+    if (result != RT_EOK)
+    {
+        return(result);
+    }
+    
+    rs485_mode_set(hinst, 1);//set to send mode
+    
+#ifndef RS485_USING_SERIAL_V2
+    hinst->tx_cpl_cnt = 0;
+    rt_event_recv(&hinst->evt, RS485_EVT_TX_CPL, (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), 0, &recved);
+#endif
+    for (int i = 0; i < iovcnt; i++)
+    {
+        int len;
+        if (iov[i].len <= 0)
+        {
+            continue;
+        }
+        len = rt_device_write(hinst->serial, 0, iov[i].base, iov[i].len);
+        if (len > 0)
+        {
+            send_len += len;
+            segs++;
+        }
+        if (len != iov[i].len)
+        {
+            result = -RT_EIO;
+            break;
+        }
+    }
+    
+#ifndef RS485_USING_SERIAL_V2
+    if (segs && (hinst->serial->open_flag & RT_DEVICE_FLAG_DMA_TX))//write returns before dma completes
+    {
+        rt_int32_t tmo = (hinst->char_us * send_len) / RS485_TICK_US + 2;
+        rt_tick_t start = rt_tick_get();
+        while (hinst->tx_cpl_cnt < segs)//each segment is indicated
+        {
+            rt_int32_t left = rs485_tmo_left(start, tmo);
+            if (left == 0)
+            {
+                break;
+            }
+            rt_event_recv(&hinst->evt, RS485_EVT_TX_CPL, (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), left, &recved);
+        }
+    }
+#endif
+    
+    rs485_mode_set(hinst, 0);//set to receive mode
+    
+    if (send_len > 0)
+    {
+        RS485_STAT_ADD(hinst, tx_bytes, send_len);
+        RS485_STAT_ADD(hinst, tx_frames, 1);
+    }
+    RS485_TRACE(hinst, RS485_TRACE_TX, iov, iovcnt, send_len, result);
+    
+    return(send_len);
+}
+
+static int rs485_send_datas(rs485_inst_t * hinst, const void *buf, int size, const struct rs485_wait *w)
+{
+    rs485_iovec_t iov;
+    
+    iov.base = (void *)buf;
+    iov.len = size;
+    
+    return(rs485_send_segs(hinst, &iov, 1, w));
+}
+
+/* discard datas left in serial, late answer of a timed out transaction */
+static void rs485_rx_flush(rs485_inst_t * hinst)
+{
+#ifndef RS485_USING_RX_RING
+    rt_uint8_t buf[32];
+#endif
+#ifndef RS485_USING_SERIAL_V2
+    rt_uint32_t recved = 0;
+#endif
+    
+    hinst->keep_pos = 0;
+    hinst->keep_len = 0;
+#ifdef RS485_USING_RX_RING
+    hinst->ring_tail = hinst->ring_head;
+#elif defined(RS485_USING_SERIAL_V2)
+    while (rs485_v2_read(hinst, buf, sizeof(buf)) > 0);
+#else
+    while (rt_device_read(hinst->serial, 0, buf, sizeof(buf)) > 0);
+#endif
+#ifndef RS485_USING_SERIAL_V2
+    rt_event_recv(&hinst->evt, RS485_EVT_RX_IND, (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), 0, &recved);
+#endif
+}
+
+static int rs485_iov_check(const rs485_iovec_t *iov, int iovcnt)
+{
+    int total = 0;
+    
+    if (iov == RT_NULL || iovcnt <= 0)
+    {
+        return(0);
+    }
+    
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (iov[i].len < 0 || (iov[i].len > 0 && iov[i].base == RT_NULL))
+        {
+            return(0);
+        }
+        total += iov[i].len;
+    }
+    
+    return(total);
+}
+
+#ifdef RS485_USING_RTO
+static void rs485_rto_clear(rs485_inst_t * hinst)
+{
+    rt_memset(hinst->rto, 0, sizeof(hinst->rto));
+    for (int i = 0; i < RS485_RTO_PEERS; i++)
+    {
+        hinst->rto[i].peer = -1;
+    }
+}
+
+/* entry of peer, a new peer takes over a free or the least recently used entry,
+   it starts from the receive timeout of instance */
+static struct rs485_rto * rs485_rto_find(rs485_inst_t * hinst, int peer)
+{
+    struct rs485_rto *rto = &hinst->rto[0];
+    rt_tick_t now = rt_tick_get();
+    rt_int32_t tmo = hinst->timeout;
+    
+    for (int i = 0; i < RS485_RTO_PEERS; i++)
+    {
+        struct rs485_rto *e = &hinst->rto[i];
+        if (e->peer == peer)
+        {
+            e->stamp = now;
+            return(e);
+        }
+        if (rto->peer >= 0 && (e->peer < 0 || (now - e->stamp) > (now - rto->stamp)))
+        {
+            rto = e;
+        }
+    }
+    
+    if (tmo < 0 || tmo > hinst->rto_max)
+    {
+        tmo = hinst->rto_max;
+    }
+    if (tmo < hinst->rto_min)
+    {
+        tmo = hinst->rto_min;
+    }
+    
+    rt_memset(rto, 0, sizeof(struct rs485_rto));
+    rto->peer = peer;
+    rto->rto_ms = tmo;
+    rto->stamp = now;
+    
+    return(rto);
+}
+
+/* learn from the latency of response as rfc 6298 with gains 1/8 and 1/4, a timeout doubles the timeout
+   and gives no sample, the latency is measured from the end of request to the first receive indication */
+static void rs485_rto_update(rs485_inst_t * hinst, struct rs485_rto *rto, int recv_len, rt_uint32_t sent)
+{
+    rt_int32_t r = (rt_int32_t)(hinst->rx_first - sent);
+    rt_uint32_t delta, us;
+    
+    if (recv_len == 0)
+    {
+        rto->timeouts++;
+        rto->rto_ms = (rto->rto_ms * 2 < hinst->rto_max) ? rto->rto_ms * 2 : hinst->rto_max;
+        return;
+    }
+    
+    if (r < 0)//the response began before the clock was read after send
+    {
+        r = 0;
+    }
+    
+    if (rto->samples == 0)
+    {
+        rto->srtt_us = r;
+        rto->rttvar_us = r / 2;
+    }
+    else
+    {
+        delta = (rto->srtt_us > (rt_uint32_t)r) ? rto->srtt_us - r : r - rto->srtt_us;
+        rto->rttvar_us = rto->rttvar_us - rto->rttvar_us / 4 + delta / 4;
+        rto->srtt_us = rto->srtt_us - rto->srtt_us / 8 + r / 8;
+    }
+    rto->samples++;
+    
+    us = rto->srtt_us + ((4 * rto->rttvar_us > RS485_TICK_US) ? 4 * rto->rttvar_us : RS485_TICK_US);
+    us = (us + 999) / 1000;
+    if (us < hinst->rto_min)
+    {
+        us = hinst->rto_min;
+    }
+    if (us > hinst->rto_max)
+    {
+        us = hinst->rto_max;
+    }
+    rto->rto_ms = us;
+}
+#endif
+
+static int rs485_dev_check(const char *name, rt_device_t *pdev)
+{
+    rt_device_t dev;
+    
+    dev = rt_device_find(name);
+    if (dev == RT_NULL)
+    {
+        LOG_E("rs485 instance initiliaze error, the serial device(%s) no found.", name);
+        return(-RT_ERROR);
+    }
+    
+    if (dev->type != RT_Device_Class_Char)
+    {
+        LOG_E("rs485 instance initiliaze error, the serial device(%s) type is not char.", name);
+        return(-RT_ERROR);
+    }
+
+    *pdev = dev;
+    
+    return(RT_EOK);
+}
+
+static void rs485_inst_init(rs485_inst_t * hinst, rt_device_t dev, const char *name, int pin, int level)
+{
+    rt_mutex_init(&hinst->lock, name, RT_IPC_FLAG_FIFO);
+    rt_mutex_init(&hinst->rx_lock, name, RT_IPC_FLAG_FIFO);
+#ifndef RS485_USING_SERIAL_V2
+    rt_event_init(&hinst->evt, name, RT_IPC_FLAG_FIFO);
+    rt_timer_init(&hinst->tx_timer, name, rs485_send_finish, hinst, 1, 
+                    (RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER));
+#else
+    hinst->rx_tmo_set = 0;
+    hinst->break_seq = 0;
+#endif
+
+    hinst->serial = dev;
+    hinst->status = 0;
+    hinst->flags = 0;
+    hinst->pin = pin;
+    hinst->level = (level != 0);
+    hinst->timeout = 0;
+    hinst->rx_stamp = 0;
+    hinst->cancel_seq = 0;
+    hinst->sw_pre_us = RS485_SW_DLY_US;
+    hinst->sw_post_us = 0;
+    hinst->sw_post_auto = 1;
+    hinst->tx_busy = 0;
+    hinst->tx_cpl_cnt = 0;
+    hinst->tx_len = 0;
+    hinst->tx_cb = RT_NULL;
+    hinst->tx_ctx = RT_NULL;
+    hinst->rx_crc_type = RS485_CRC_NONE;
+    hinst->rx_crc = 0;
+    hinst->keep_pos = 0;
+    hinst->keep_len = 0;
+#ifdef RS485_USING_STATS
+    rt_memset(&hinst->stats, 0, sizeof(hinst->stats));
+#endif
+#ifdef RS485_USING_TRACE
+    hinst->trace_head = 0;
+#endif
+#ifdef RS485_USING_RTO
+    hinst->rx_first = 0;
+    hinst->rx_first_wait = 0;
+    hinst->rto_min = RS485_RTO_MIN;
+    hinst->rto_max = RS485_RTO_MAX;
+    rs485_rto_clear(hinst);
+#endif
+#ifdef RS485_USING_FRAME_HANDLER
+    hinst->handler = RT_NULL;
+    hinst->handler_ctx = RT_NULL;
+    hinst->loop = RT_NULL;
+    hinst->loop_next = RT_NULL;
+    hinst->loop_bit = 0;
+    hinst->asm_len = 0;
+#endif
+#ifdef RS485_USING_FRAME_POOL
+    hinst->frame_free = (rt_uint32_t)((1ULL << RS485_FRAME_POOL_NUM) - 1);
+    for (int i = 0; i < RS485_FRAME_POOL_NUM; i++)
+    {
+        hinst->frames[i].data = hinst->frame_buf[i];
+        hinst->frames[i].len = 0;
+    }
+#endif
+}
+
+static void rs485_inst_deinit(rs485_inst_t * hinst)
+{
+#ifdef RS485_USING_FRAME_HANDLER
+    rs485_loop_remove(hinst);
+#endif
+    
+    rs485_disconn(hinst);
+
+    hinst->alloc = 0;
+#ifndef RS485_USING_SERIAL_V2
+    rt_timer_detach(&hinst->tx_timer);
+    rt_event_detach(&hinst->evt);
+#endif
+    rt_mutex_detach(&hinst->rx_lock);
+    rt_mutex_detach(&hinst->lock);
+}
+
+/* 
+ * @brief   initialize rs485 instance statically, no heap is used
+ * @param   hinst       - instance to initialize, global or static storage
+ * @param   serial      - serial device name
+ * @param   baudrate    - serial baud rate
+ * @param   parity      - serial parity mode
+ * @param   pin         - mode contrle pin
+ * @param   level       - send mode level
+ * @retval  0 - success, other - error
+ */
+int rs485_init(rs485_inst_t * hinst, const char *name, int baudrate, int parity, int pin, int level)
+{
+    rt_device_t dev;
+    
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 init fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    if (rs485_dev_check(name, &dev) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+
+    rs485_inst_init(hinst, dev, name, pin, level);
+    hinst->alloc = 1;
+    
+    rs485_config(hinst, baudrate, 8, parity, 0);
+
+    LOG_D("rs485 init success.");
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   detach rs485 instance initialized statically
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_detach(rs485_inst_t * hinst)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 detach fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    if (hinst->alloc != 1)
+    {
+        LOG_E("rs485 detach fail. hinst is not initialized statically.");
+        return(-RT_ERROR);
+    }
+    
+    rs485_inst_deinit(hinst);
+    
+    LOG_D("rs485 detach success.");
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   create rs485 instance dynamically
+ * @param   serial      - serial device name
+ * @param   baudrate    - serial baud rate
+ * @param   parity      - serial parity mode
+ * @param   pin         - mode contrle pin
+ * @param   level       - send mode level
+ * @retval  instance handle
+ */
+rs485_inst_t * rs485_create(const char *name, int baudrate, int parity, int pin, int level)
+{
+    rs485_inst_t *hinst;
+    rt_device_t dev;
+    
+    if (rs485_dev_check(name, &dev) != RT_EOK)
+    {
+        return(RT_NULL);
+    }
+    
+    hinst = rt_malloc(sizeof(struct rs485_inst));
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 create fail. no memory for rs485 create instance.");
+        return(RT_NULL);
+    }
+
+    rs485_inst_init(hinst, dev, name, pin, level);
+    hinst->alloc = 2;
+    
+    rs485_config(hinst, baudrate, 8, parity, 0);
+
+    LOG_D("rs485 create success.");
+
+    return(hinst);
+}
+
+/* 
+ * @brief   destory rs485 instance created dynamically
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_destory(rs485_inst_t * hinst)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 destory fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    if (hinst->alloc != 2)
+    {
+        LOG_E("rs485 destory fail. hinst is not created dynamically.");
+        return(-RT_ERROR);
+    }
+    
+    rs485_inst_deinit(hinst);
+    
+    rt_free(hinst);
+    
+    LOG_D("rs485 destory success.");
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   config rs485 params 
+ * @param   hinst       - instance handle
+ * @param   baudrate    - baudrate of communication
+ * @param   databits    - data bits, 5~8
+ * @param   parity      - parity bit, 0~2, 0 - none, 1 - odd, 2 - even
+ * @param   stopbits    - stop bits, 0~1, 0 - 1 stop bit, 1 - 2 stop bits
+ * @retval  0 - success, other - error
+ */
+int rs485_config(rs485_inst_t * hinst, int baudrate, int databits, int parity, int stopbits)
+{
+    struct serial_configure config = RT_SERIAL_CONFIG_DEFAULT;
+
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 config fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+
+    if (baudrate <= 0)
+    {
+        LOG_E("rs485 config fail. baudrate is error.");
+        return(-RT_ERROR);
+    }
+
+    hinst->char_us = rs485_cal_char_us(baudrate, databits, parity, stopbits);
+    hinst->byte_tmo = rs485_cal_byte_tmo(hinst->char_us);
+    if (hinst->sw_post_auto)
+    {
+        hinst->sw_post_us = hinst->char_us;
+    }
+
+    config.baud_rate = baudrate;
+    config.data_bits = databits;
+    config.parity = parity;
+    config.stop_bits = stopbits;
+    rt_device_control(hinst->serial, RT_DEVICE_CTRL_CONFIG, &config);
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   set wait datas timeout for receiving 
+ * @param   hinst       - instance handle
+ * @param   tmo_ms      - receive wait timeout, 0--no wait, <0--wait forever, >0--wait timeout, default = 0
+ * @retval  0 - success, other - error
+ */
+int rs485_set_recv_tmo(rs485_inst_t * hinst, int tmo_ms)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 set recv timeout fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    hinst->timeout = tmo_ms;
+    
+    LOG_D("rs485 set recv timeout success. the value is %d.", tmo_ms);
+
+    return(RT_EOK);
+}
+ 
+/* 
+ * @brief   set byte interval timeout for receiving
+ * @param   hinst       - instance handle
+ * @param   tmo_ms      - byte interval timeout, default is calculated from baudrate
+ * @retval  0 - success, other - error
+ */
+int rs485_set_byte_tmo(rs485_inst_t * hinst, int tmo_ms)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 set byte timeout fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    if (tmo_ms < RS485_BYTE_TMO_MIN)
+    {
+        tmo_ms = RS485_BYTE_TMO_MIN;
+    }
+    else if (tmo_ms > RS485_BYTE_TMO_MAX)
+    {
+        tmo_ms = RS485_BYTE_TMO_MAX;
+    }
+    
+    hinst->byte_tmo = tmo_ms * 1000;
+
+    LOG_D("rs485 set byte timeout success. the value is %d.", tmo_ms);
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   set byte interval timeout for receiving in microseconds
+ * @param   hinst       - instance handle
+ * @param   tmo_us      - byte interval timeout, us
+ * @retval  0 - success, other - error
+ */
+int rs485_set_byte_tmo_us(rs485_inst_t * hinst, int tmo_us)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 set byte timeout fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    if (tmo_us < RS485_BYTE_TMO_US_MIN)
+    {
+        tmo_us = RS485_BYTE_TMO_US_MIN;
+    }
+    else if (tmo_us > RS485_BYTE_TMO_MAX * 1000)
+    {
+        tmo_us = RS485_BYTE_TMO_MAX * 1000;
+    }
+    
+    hinst->byte_tmo = tmo_us;
+
+    LOG_D("rs485 set byte timeout success. the value is %d us.", tmo_us);
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   set byte interval timeout for receiving in character times
+ * @param   hinst       - instance handle
+ * @param   chars_x10   - byte interval timeout, 1/10 character time, 35 -- 3.5 characters
+ * @retval  0 - success, other - error
+ */
+int rs485_set_byte_tmo_char(rs485_inst_t * hinst, int chars_x10)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 set byte timeout fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    return(rs485_set_byte_tmo_us(hinst, hinst->char_us * chars_x10 / 10));
+}
+
+/* 
+ * @brief   set delays of switching transceiver direction
+ * @param   hinst       - instance handle
+ * @param   pre_us      - delay after switching to send mode, us, <0--default RS485_SW_DLY_US
+ * @param   post_us     - delay before switching to receive mode after datas are written, us,
+ *                        <0--one character time of current config, the drain of uart shift register
+ *                        with hardware direction control they are the assertion and deassertion times of uart,
+ *                        the default post delay is 0, the uart deasserts after the last stop bit
+ * @retval  0 - success, other - error
+ */
+int rs485_set_sw_dly(rs485_inst_t * hinst, int pre_us, int post_us)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 set switch delay fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    if (pre_us < 0)
+    {
+        pre_us = RS485_SW_DLY_US;
+    }
+    if (pre_us > 0xFFFF)
+    {
+        pre_us = 0xFFFF;
+    }
+    hinst->sw_pre_us = pre_us;
+    
+    hinst->sw_post_auto = (post_us < 0);
+    if (post_us < 0)
+    {
+        post_us = hinst->char_us;
+    }
+    if (post_us > 0xFFFF)
+    {
+        post_us = 0xFFFF;
+    }
+    hinst->sw_post_us = post_us;
+    
+    if (hinst->status && (hinst->flags & RS485_CONN_HW_DE))//the uart times the switch
+    {
+        if (rs485_hw_de_set(hinst, 1) != RT_EOK)
+        {
+            LOG_E("rs485 set switch delay fail. serial control error.");
+            return(-RT_ERROR);
+        }
+    }
+    
+    LOG_D("rs485 set switch delay success. pre %d us, post %d us.", pre_us, post_us);
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   open rs485 connect, with RS485_USING_HW_DE it requests hardware direction control like RS485_CONN_HW_DE
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_connect(rs485_inst_t * hinst)
+{
+#ifdef RS485_USING_HW_DE
+    return(rs485_connect_ex(hinst, RS485_CONN_HW_DE));
+#else
+    return(rs485_connect_ex(hinst, 0));
+#endif
+}
+
+/* 
+ * @brief   open rs485 connect with options
+ * @param   hinst       - instance handle
+ * @param   flags       - connect flags, RS485_CONN_xxx
+ * @retval  0 - success, other - error
+ */
+int rs485_connect_ex(rs485_inst_t * hinst, int flags)
+{
+    rt_uint16_t oflag = RT_DEVICE_OFLAG_RDWR;
+    
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 connect fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+
+    if (hinst->status == 1)//is connected
+    {
+        LOG_D("rs485 is connected.");
+        return(RT_EOK);
+    }
+    
+#ifdef RS485_USING_SERIAL_V2
+    if (flags & (RS485_CONN_DMA_RX | RS485_CONN_DMA_TX | RS485_CONN_IDLE_END))
+    {
+        LOG_W("rs485 serial v2 selects dma by its driver config, dma connect flags are ignored.");
+        flags &= ~(RS485_CONN_DMA_RX | RS485_CONN_DMA_TX | RS485_CONN_IDLE_END);
+    }
+    oflag |= (RT_DEVICE_FLAG_RX_BLOCKING | RT_DEVICE_FLAG_TX_BLOCKING);
+#else
+    if (flags & RS485_CONN_DMA_RX)
+    {
+        if (hinst->serial->flag & RT_DEVICE_FLAG_DMA_RX)
+        {
+            oflag |= RT_DEVICE_FLAG_DMA_RX;
+        }
+        else
+        {
+            LOG_W("rs485 serial does not support dma receive, use interrupt receive.");
+            flags &= ~RS485_CONN_DMA_RX;
+        }
+    }
+    if ((flags & RS485_CONN_DMA_RX) == 0)
+    {
+        oflag |= RT_DEVICE_FLAG_INT_RX;
+        flags &= ~RS485_CONN_IDLE_END;//interrupt receive indicates each byte, only the gap ends the frame
+    }
+    
+    if (flags & RS485_CONN_DMA_TX)
+    {
+        if (hinst->serial->flag & RT_DEVICE_FLAG_DMA_TX)
+        {
+            oflag |= RT_DEVICE_FLAG_DMA_TX;
+        }
+        else
+        {
+            LOG_W("rs485 serial does not support dma transmit, use synchronous transmit.");
+            flags &= ~RS485_CONN_DMA_TX;
+        }
+    }
+#endif
+    
+    if ( rt_device_open(hinst->serial, oflag) != RT_EOK)
+    {
+        LOG_E("rs485 instance connect error. serial open fail.");
+        return(-RT_ERROR);
+    }
+    
+#ifdef RS485_USING_SERIAL_V2
+    hinst->rx_tmo_set = RT_WAITING_FOREVER;//unknown after open, set it explicitly
+    rs485_v2_rx_tmo(hinst, 0);
+#endif
+    
+    if (flags & RS485_CONN_HW_DE)
+    {
+        if (rs485_hw_de_set(hinst, 1) != RT_EOK)
+        {
+            LOG_W("rs485 serial does not support hardware direction control, use control pin.");
+            flags &= ~RS485_CONN_HW_DE;
+        }
+    }
+    
+    if ((hinst->pin >= 0) && ((flags & RS485_CONN_HW_DE) == 0))
+    {
+        rt_pin_mode(hinst->pin, PIN_MODE_OUTPUT);
+        rt_pin_write(hinst->pin, ! hinst->level);
+    }
+
+
+    hinst->serial->user_data = hinst;
+#ifdef RS485_USING_RX_RING
+    hinst->ring_head = 0;
+    hinst->ring_tail = 0;
+#endif
+    hinst->serial->rx_indicate = rs485_recv_ind_hook;
+#ifndef RS485_USING_SERIAL_V2
+    hinst->serial->tx_complete = rs485_send_cpl_hook;
+#endif
+    hinst->flags = flags;
+    hinst->status = 1;
+
+    LOG_D("rs485 connect success.");
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   close rs485 connect
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_disconn(rs485_inst_t * hinst)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 disconnect fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    if (hinst->status == 0)//is not connected
+    {
+        LOG_D("rs485 is not connected.");
+        return(RT_EOK);
+    }
+
+    rt_mutex_take(&hinst->lock, RT_WAITING_FOREVER);
+    
+    rs485_tx_drain(hinst, RT_NULL);
+
+    if (hinst->serial)
+    {
+        hinst->serial->rx_indicate = RT_NULL;
+        hinst->serial->tx_complete = RT_NULL;
+        if (hinst->flags & RS485_CONN_HW_DE)
+        {
+            rs485_hw_de_set(hinst, 0);
+        }
+        rt_device_close(hinst->serial);
+    }
+    
+    if (RS485_PIN_CTRL(hinst))
+    {
+        rt_pin_mode(hinst->pin, PIN_MODE_INPUT);
+    }
+    
+    hinst->status = 0;
+    
+    rt_mutex_release(&hinst->lock);
+    
+    LOG_D("rs485 disconnect success.");
+    
+    return(RT_EOK);
+}
+
+/* receive of rs485_recv_ex and rs485_recv_dl, the first byte is waited up to timeout and the limits of call */
+static int rs485_recv_within(rs485_inst_t * hinst, void *buf, int size, rs485_frame_done_t done, void *ctx,
+                            rt_int32_t timeout, struct rs485_wait *w)
+{
+    int recv_len = 0;
+    rt_int32_t tmo;
+    rt_err_t rc;
+    
+    if (hinst->status == 0)
+    {
+        LOG_E("rs485 receive fail. it is not connected.");
+        return(-RT_ERROR);
+    }
+    
+    tmo = rs485_wait_left(w, RT_WAITING_FOREVER);
+    rc = (tmo == 0) ? -RT_ETIMEOUT : rt_mutex_take(&hinst->rx_lock, tmo);
+    if (rc == -RT_ETIMEOUT)//another receiver held it up to the deadline
+    {
+        return(0);
+    }
+    if (rc != RT_EOK)
+    {
+        LOG_E("rs485 receive fail. it is destoried.");
+        return(-RT_ERROR);
+    }
+    
+    recv_len = rs485_recv_idle(hinst, buf, size, done, ctx, timeout, w);
+    
+    rt_mutex_release(&hinst->rx_lock);
+    
+    return(recv_len);
+}
+
+/* 
+ * @brief   receive datas from rs485, the bus is not held while waiting the first byte,
+ *          so transmits of other threads are not blocked by the wait
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_recv(rs485_inst_t * hinst, void *buf, int size)
+{
+    return(rs485_recv_ex(hinst, buf, size, RT_NULL, RT_NULL));
+}
+
+/* 
+ * @brief   receive datas from rs485, it returns as soon as the predicate reports the frame completed,
+ *          without waiting the frame gap
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @param   done        - frame completed predicate, called after each chunk received, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_recv_ex(rs485_inst_t * hinst, void *buf, int size, rs485_frame_done_t done, void *ctx)
+{
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || buf == RT_NULL || size == 0)
+    {
+        LOG_E("rs485 receive fail. param error.");
+        return(-RT_ERROR);
+    }
+    
+    rs485_wait_init(hinst, &w, 0, 0);
+    
+    return(rs485_recv_within(hinst, buf, size, done, ctx, hinst->timeout, &w));
+}
+
+/* 
+ * @brief   receive datas from rs485 until an absolute deadline, the frame still arriving at the deadline 
+ *          is dropped, so a chattering device can not extend the call
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @param   deadline    - tick the call returns by, such as rt_tick_get() + rt_tick_from_millisecond(ms)
+ * @retval  >0 - length of received datas, 0 - no datas before the deadline, 
+ *          -RT_ETIMEOUT - the deadline passed inside a frame, -RT_EINTR - cancelled, other <0 - error
+ */
+int rs485_recv_dl(rs485_inst_t * hinst, void *buf, int size, rs485_frame_done_t done, void *ctx, rt_tick_t deadline)
+{
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || buf == RT_NULL || size == 0)
+    {
+        LOG_E("rs485 receive dl fail. param error.");
+        return(-RT_ERROR);
+    }
+    
+    rs485_wait_init(hinst, &w, 1, deadline);
+    
+    return(rs485_recv_within(hinst, buf, size, done, ctx, RT_WAITING_FOREVER, &w));
+}
+
+/* 
+ * @brief   receive datas from rs485 until the delimiter is received, it returns as soon as the delimiter is seen,
+ *          datas received after the delimiter are kept for next receive
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of received datas
+ * @param   delim       - delimiter
+ * @param   dlen        - length of delimiter
+ * @retval  >=0 - length of received datas including delimiter, <0 - error
+ */
+int rs485_recv_until(rs485_inst_t * hinst, void *buf, int size, const void *delim, int dlen)
+{
+    struct rs485_delim d;
+    
+    if (delim == RT_NULL || dlen <= 0 || dlen > size)
+    {
+        LOG_E("rs485 receive until fail. delimiter is error.");
+        return(-RT_ERROR);
+    }
+    
+    d.delim = delim;
+    d.dlen = dlen;
+    d.scanned = 0;
+    
+    return(rs485_recv_ex(hinst, buf, size, rs485_delim_done, &d));
+}
+
+/* send of rs485_send, rs485_sendv and rs485_send_dl, the bus is waited within the limits of call */
+static int rs485_send_within(rs485_inst_t * hinst, const rs485_iovec_t *iov, int iovcnt, const struct rs485_wait *w)
+{
+    int send_len = 0;
+    rt_err_t rc;
+    
+    if (hinst->status == 0)
+    {
+        LOG_E("rs485 send fail. it is not connected.");
+        return(-RT_ERROR);
+    }
+    
+    rc = rs485_bus_wait(hinst, w);
+    if (rc != RT_EOK)
+    {
+        if (rc != -RT_ETIMEOUT && rc != -RT_EINTR)
+        {
+            LOG_E("rs485 send fail. it is destoried.");
+            rc = -RT_ERROR;
+        }
+        return(rc);
+    }
+
+    send_len = rs485_send_segs(hinst, iov, iovcnt, w);
+    
+    rt_mutex_release(&hinst->lock);
+
+    return(send_len);
+}
+
+/* 
+ * @brief   send datas to rs485
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - length of send datas
+ * @retval  >=0 - length of sent datas, <0 - error
+ */
+int rs485_send(rs485_inst_t * hinst, void *buf, int size)
+{
+    rs485_iovec_t iov;
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || buf == RT_NULL || size == 0)
+    {
+        LOG_E("rs485 send fail. param is error.");
+        return(-RT_ERROR);
+    }
+    
+    iov.base = buf;
+    iov.len = size;
+    rs485_wait_init(hinst, &w, 0, 0);
+    
+    return(rs485_send_within(hinst, &iov, 1, &w));
+}
+
+/* 
+ * @brief   send datas to rs485 if the bus is got before an absolute deadline, 
+ *          the transmit itself is not broken, it is bounded by the wire time
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - length of send datas
+ * @param   deadline    - tick the bus must be got by
+ * @retval  >=0 - length of sent datas, -RT_ETIMEOUT - the bus was not got before the deadline, 
+ *          -RT_EINTR - cancelled, other <0 - error
+ */
+int rs485_send_dl(rs485_inst_t * hinst, const void *buf, int size, rt_tick_t deadline)
+{
+    rs485_iovec_t iov;
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || buf == RT_NULL || size == 0)
+    {
+        LOG_E("rs485 send dl fail. param is error.");
+        return(-RT_ERROR);
+    }
+    
+    iov.base = (void *)buf;
+    iov.len = size;
+    rs485_wait_init(hinst, &w, 1, deadline);
+    
+    return(rs485_send_within(hinst, &iov, 1, &w));
+}
+
+/* 
+ * @brief   send datas gathered from segments to rs485 as one frame, the segments are written
+ *          back to back under one direction switch, no copy into a staging buffer
+ * @param   hinst       - instance handle
+ * @param   iov         - segments array
+ * @param   iovcnt      - count of segments
+ * @retval  >=0 - length of sent datas, <0 - error
+ */
+int rs485_sendv(rs485_inst_t * hinst, const rs485_iovec_t *iov, int iovcnt)
+{
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || rs485_iov_check(iov, iovcnt) == 0)
+    {
+        LOG_E("rs485 sendv fail. param is error.");
+        return(-RT_ERROR);
+    }
+    
+    rs485_wait_init(hinst, &w, 0, 0);
+    
+    return(rs485_send_within(hinst, iov, iovcnt, &w));
+}
+
+/* 
+ * @brief   send datas to rs485 asynchronously, returns when the datas are queued to dma transmit.
+ *          the transmit complete indication switches the bus to receive and then calls cb.
+ *          without RS485_CONN_DMA_TX connect it sends synchronously and calls cb before returns.
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr, it must be kept until the completion
+ * @param   size        - length of send datas
+ * @param   cb          - completion callback, can be NULL
+ * @param   ctx         - context passed to cb
+ * @retval  0 - success, other - error
+ */
+int rs485_send_async(rs485_inst_t * hinst, const void *buf, int size, rs485_send_cpl_t cb, void *ctx)
+{
+    struct rs485_wait w;
+    int send_len = 0;
+    int rc;
+    
+    if (hinst == RT_NULL || buf == RT_NULL || size <= 0)
+    {
+        LOG_E("rs485 send async fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    if (hinst->status == 0)
+    {
+        LOG_E("rs485 send async fail. it is not connected.");
+        return(-RT_ERROR);
+    }
+    
+    if ((hinst->flags & RS485_CONN_DMA_TX) == 0)//no dma transmit, send synchronously
+    {
+        send_len = rs485_send(hinst, (void *)buf, size);
+        if (cb)
+        {
+            cb(hinst, send_len, ctx);
+        }
+        return(send_len < 0 ? send_len : RT_EOK);
+    }
+    
+    rs485_wait_init(hinst, &w, 0, 0);
+    if (rs485_bus_take(hinst) != RT_EOK)
+    {
+        LOG_E("rs485 send async fail. it is destoried.");
+        return(-RT_ERROR);
+    }
+    
+    rc = rs485_tx_drain(hinst, &w);//one asynchronous transmit at a time
+    if (rc != RT_EOK)
+    {
+        rt_mutex_release(&hinst->lock);
+        return(rc);
+    }
+    
+    hinst->tx_len = size;
+    hinst->tx_cb = cb;
+    hinst->tx_ctx = ctx;
+    hinst->tx_busy = 1;
+    rs485_mode_set(hinst, 1);//set to send mode, switched back by the completion
+    
+    send_len = rt_device_write(hinst->serial, 0, buf, size);
+    if (send_len <= 0)
+    {
+        hinst->tx_busy = 0;
+        rs485_mode_set(hinst, 0);
+        RS485_TRACE(hinst, RS485_TRACE_TX, RT_NULL, 0, 0, -RT_EIO);
+        rt_mutex_release(&hinst->lock);
+        LOG_E("rs485 send async fail. serial write error.");
+        return(-RT_EIO);
+    }
+    RS485_STAT_ADD(hinst, tx_bytes, send_len);
+    RS485_STAT_ADD(hinst, tx_frames, 1);
+#ifdef RS485_USING_TRACE
+    {
+        rs485_iovec_t iov = {(void *)buf, send_len};
+        rs485_trace_put(hinst, RS485_TRACE_TX, &iov, 1, send_len, (send_len == size) ? RT_EOK : -RT_EIO);
+    }
+#endif
+    
+    rt_mutex_release(&hinst->lock);
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   wait the asynchronous transmit completed
+ * @param   hinst       - instance handle
+ * @param   tmo_ms      - wait timeout, ms, RT_WAITING_FOREVER--wait forever
+ * @retval  0 - success, -RT_ETIMEOUT - timeout, other - error
+ */
+int rs485_send_wait(rs485_inst_t * hinst, int tmo_ms)
+{
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 send wait fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+    
+    return(rs485_tx_wait(hinst, (tmo_ms < 0) ? RT_WAITING_FOREVER : rt_tick_from_millisecond(tmo_ms), RT_NULL));
+}
+
+/* 
+ * @brief   break rs485 receive wait
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_break_recv(rs485_inst_t * hinst)
+{
+    if ((hinst == RT_NULL) || (hinst->alloc == 0))
+    {
+        return(-RT_ERROR);
+    }
+
+#ifdef RS485_USING_SERIAL_V2
+    hinst->break_seq++;//seen by the receive after its slice of blocking read
+#else
+    rt_event_send(&hinst->evt, RS485_EVT_RX_BREAK);
+#endif
+    
+    return (RT_EOK);
+}
+
+/* 
+ * @brief   cancel blocking calls in progress on instance, they return -RT_EINTR promptly from any wait, 
+ *          of the bus, the first byte or the frame gap, a transmit in progress completes first, 
+ *          calls started after it are not affected, it can be called from interrupt
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_cancel(rs485_inst_t * hinst)
+{
+    rt_base_t level;
+    
+    if ((hinst == RT_NULL) || (hinst->alloc == 0))
+    {
+        return(-RT_ERROR);
+    }
+    
+    level = rt_hw_interrupt_disable();
+    hinst->cancel_seq++;
+    rt_hw_interrupt_enable(level);
+#ifndef RS485_USING_SERIAL_V2
+    rt_event_send(&hinst->evt, RS485_EVT_CANCEL);
+#endif
+    
+    return(RT_EOK);
+}
+
+/* transaction of transferv within the limits of call, the response timeout is learned for the peer 
+   when peer >= 0, or it is the given timeout */
+static int rs485_transfer_segs(rs485_inst_t * hinst, int peer, const rs485_iovec_t *send_iov, int send_cnt, 
+                                const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx,
+                                rt_int32_t timeout, struct rs485_wait *w)
+{
+    int recv_len = 0;
+    rt_uint32_t start;
+    rt_err_t rc;
+#ifdef RS485_USING_RTO
+    struct rs485_rto *rto = RT_NULL;
+    rt_uint32_t sent;
+#endif
+    
+    if (hinst->status == 0)
+    {
+        LOG_E("rs485 transferv fail. it is not connected.");
+        return(-RT_ERROR);
+    }
+
+    rc = rs485_bus_wait(hinst, w);
+    if (rc != RT_EOK)
+    {
+        if (rc != -RT_ETIMEOUT && rc != -RT_EINTR)
+        {
+            LOG_E("rs485 transferv fail. it is destoried.");
+            rc = -RT_ERROR;
+        }
+        return(rc);
+    }
+
+#ifdef RS485_USING_RTO
+    if (peer >= 0)
+    {
+        rto = rs485_rto_find(hinst, peer);
+        timeout = rt_tick_from_millisecond(rto->rto_ms) + 1;//the wait starts inside the current tick
+    }
+#endif
+
+    rs485_rx_flush(hinst);
+#ifdef RS485_USING_RTO
+    hinst->rx_first_wait = (peer >= 0);//armed before send, a response indicated before sent is clamped
+#endif
+    start = rs485_get_us();
+    rc = rs485_send_segs(hinst, send_iov, send_cnt, w);
+    if (rc <= 0)
+    {
+        rt_mutex_release(&hinst->lock);
+        if (rc == -RT_ETIMEOUT || rc == -RT_EINTR)
+        {
+            return(rc);
+        }
+        LOG_E("rs485 transferv fail. send datas error.");
+        return(-RT_ERROR);
+    }
+#ifdef RS485_USING_RTO
+    sent = rs485_get_us();
+#endif
+
+    if (recv_cnt > 0)
+    {
+        recv_len = rs485_recv_segs(hinst, recv_iov, recv_cnt, timeout, done, ctx, w);
+    }
+    if (recv_len > 0)
+    {
+        RS485_STAT_XFER(hinst, start);
+    }
+#ifdef RS485_USING_RTO
+    hinst->rx_first_wait = 0;
+    if (rto != RT_NULL && recv_len >= 0)
+    {
+        rs485_rto_update(hinst, rto, recv_len, sent);
+    }
+#endif
+    
+    rt_mutex_release(&hinst->lock);
+    
+    return(recv_len);
+}
+
+/* 
+ * @brief   send data to rs485 and then receive response data from rs485
+ * @param   hinst       - instance handle
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, void *recv_buf, int recv_size)
+{
+    return(rs485_send_then_recv_ex(hinst, send_buf, send_len, recv_buf, recv_size, RT_NULL, RT_NULL));
+}
+
+/* 
+ * @brief   send data to rs485 and then receive response data from rs485, 
+ *          it returns as soon as the predicate reports the response completed, without waiting the frame gap
+ * @param   hinst       - instance handle
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @param   done        - frame completed predicate, called after each chunk received, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_send_then_recv_ex(rs485_inst_t * hinst, const void *send_buf, int send_len, void *recv_buf, int recv_size, 
+                            rs485_frame_done_t done, void *ctx)
+{
+    int recv_len = 0;
+    rt_uint32_t start;
+    struct rs485_wait w;
+    rt_err_t rc;
+    
+    if (hinst == RT_NULL || send_buf == RT_NULL || send_len == 0 || recv_buf == RT_NULL || recv_size == 0)
+    {
+        LOG_E("rs485 send then recv fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    if (hinst->status == 0)
+    {
+        LOG_E("rs485 send_then_recv fail. it is not connected.");
+        return(-RT_ERROR);
+    }
+
+    rs485_wait_init(hinst, &w, 0, 0);
+    rc = rs485_bus_wait(hinst, &w);
+    if (rc != RT_EOK)
+    {
+        if (rc != -RT_EINTR)
+        {
+            LOG_E("rs485 send_then_recv fail. it is destoried.");
+            rc = -RT_ERROR;
+        }
+        return(rc);
+    }
+
+    start = rs485_get_us();
+    send_len = rs485_send_datas(hinst, send_buf, send_len, &w);
+    if (send_len < 0)
+    {
+        rt_mutex_release(&hinst->lock);
+        if (send_len == -RT_EINTR)
+        {
+            return(send_len);
+        }
+        LOG_E("rs485 send_then_recv fail. send datas error.");
+        return(-RT_ERROR);
+    }
+
+    recv_len = rs485_recv_datas(hinst, recv_buf, recv_size, hinst->timeout, done, ctx, &w);
+    if (recv_len > 0)
+    {
+        RS485_STAT_XFER(hinst, start);
+    }
+    
+    rt_mutex_release(&hinst->lock);
+    
+    return(recv_len);
+}
+
+/* 
+ * @brief   send data to rs485 and then receive response data from rs485 until the delimiter is received,
+ *          it returns as soon as the delimiter is seen, datas received after the delimiter are kept for next receive
+ * @param   hinst       - instance handle
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @param   delim       - delimiter
+ * @param   dlen        - length of delimiter
+ * @retval  >=0 - length of received datas including delimiter, <0 - error
+ */
+int rs485_send_then_recv_until(rs485_inst_t * hinst, const void *send_buf, int send_len, void *recv_buf, int recv_size, 
+                                const void *delim, int dlen)
+{
+    struct rs485_delim d;
+    
+    if (delim == RT_NULL || dlen <= 0 || dlen > recv_size)
+    {
+        LOG_E("rs485 send then recv until fail. delimiter is error.");
+        return(-RT_ERROR);
+    }
+    
+    d.delim = delim;
+    d.dlen = dlen;
+    d.scanned = 0;
+    
+    return(rs485_send_then_recv_ex(hinst, send_buf, send_len, recv_buf, recv_size, rs485_delim_done, &d));
+}
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response data from rs485
+ * @param   hinst       - instance handle
+ * @param   iov         - send segments array
+ * @param   iovcnt      - count of send segments
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_send_then_recvv(rs485_inst_t * hinst, const rs485_iovec_t *iov, int iovcnt, void *recv_buf, int recv_size)
+{
+    int recv_len = 0;
+    rt_uint32_t start;
+    struct rs485_wait w;
+    rt_err_t rc;
+    
+    if (hinst == RT_NULL || rs485_iov_check(iov, iovcnt) == 0 || recv_buf == RT_NULL || recv_size == 0)
+    {
+        LOG_E("rs485 send then recvv fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    if (hinst->status == 0)
+    {
+        LOG_E("rs485 send_then_recvv fail. it is not connected.");
+        return(-RT_ERROR);
+    }
+
+    rs485_wait_init(hinst, &w, 0, 0);
+    rc = rs485_bus_wait(hinst, &w);
+    if (rc != RT_EOK)
+    {
+        if (rc != -RT_EINTR)
+        {
+            LOG_E("rs485 send_then_recvv fail. it is destoried.");
+            rc = -RT_ERROR;
+        }
+        return(rc);
+    }
+
+    start = rs485_get_us();
+    rc = rs485_send_segs(hinst, iov, iovcnt, &w);
+    if (rc <= 0)
+    {
+        rt_mutex_release(&hinst->lock);
+        if (rc == -RT_EINTR)
+        {
+            return(rc);
+        }
+        LOG_E("rs485 send_then_recvv fail. send datas error.");
+        return(-RT_ERROR);
+    }
+
+    recv_len = rs485_recv_datas(hinst, recv_buf, recv_size, hinst->timeout, RT_NULL, RT_NULL, &w);
+    if (recv_len > 0)
+    {
+        RS485_STAT_XFER(hinst, start);
+    }
+    
+    rt_mutex_release(&hinst->lock);
+    
+    return(recv_len);
+}
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response scattered into segments,
+ *          the receive completes when all receive segments are filled or the frame gap elapses
+ * @param   hinst       - instance handle
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, 0--no response
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_transferv(rs485_inst_t * hinst, const rs485_iovec_t *send_iov, int send_cnt, 
+                    const rs485_iovec_t *recv_iov, int recv_cnt)
+{
+    return(rs485_transferv_ex(hinst, send_iov, send_cnt, recv_iov, recv_cnt, RT_NULL, RT_NULL));
+}
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response scattered into segments,
+ *          the receive completes when all receive segments are filled, the predicate reports 
+ *          the response completed or the frame gap elapses
+ * @param   hinst       - instance handle
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, 0--no response
+ * @param   done        - frame completed predicate, it sees the first receive segment and the total received length,
+ *                        NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_transferv_ex(rs485_inst_t * hinst, const rs485_iovec_t *send_iov, int send_cnt, 
+                        const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx)
+{
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || rs485_iov_check(send_iov, send_cnt) == 0 || 
+        (recv_cnt > 0 && rs485_iov_check(recv_iov, recv_cnt) == 0))
+    {
+        LOG_E("rs485 transferv fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    rs485_wait_init(hinst, &w, 0, 0);
+
+    return(rs485_transfer_segs(hinst, -1, send_iov, send_cnt, recv_iov, recv_cnt, done, ctx, hinst->timeout, &w));
+}
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response scattered into segments,
+ *          the whole transaction ends by an absolute deadline instead of the receive timeout of instance,
+ *          a response still arriving at the deadline is dropped, so a chattering device can not extend it
+ * @param   hinst       - instance handle
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, 0--no response
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @param   deadline    - tick the call returns by, such as rt_tick_get() + rt_tick_from_millisecond(ms)
+ * @retval  >0 - length of received datas, 0 - no response before the deadline, -RT_ETIMEOUT - the deadline 
+ *          passed before the bus was got or inside the response, -RT_EINTR - cancelled, other <0 - error
+ */
+int rs485_transferv_dl(rs485_inst_t * hinst, const rs485_iovec_t *send_iov, int send_cnt, 
+                        const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx, 
+                        rt_tick_t deadline)
+{
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || rs485_iov_check(send_iov, send_cnt) == 0 || 
+        (recv_cnt > 0 && rs485_iov_check(recv_iov, recv_cnt) == 0))
+    {
+        LOG_E("rs485 transferv dl fail. param is error.");
+        return(-RT_ERROR);
+    }
+    
+    rs485_wait_init(hinst, &w, 1, deadline);
+
+    return(rs485_transfer_segs(hinst, -1, send_iov, send_cnt, recv_iov, recv_cnt, done, ctx, RT_WAITING_FOREVER, &w));
+}
+
+/* 
+ * @brief   send data to rs485 and then receive response data from rs485 by an absolute deadline,
+ *          stale datas are discarded before sending like rs485_transferv_dl
+ * @param   hinst       - instance handle
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @param   deadline    - tick the call returns by
+ * @retval  same as rs485_transferv_dl
+ */
+int rs485_send_then_recv_dl(rs485_inst_t * hinst, const void *send_buf, int send_len, void *recv_buf, int recv_size, 
+                            rs485_frame_done_t done, void *ctx, rt_tick_t deadline)
+{
+    rs485_iovec_t send_iov, recv_iov;
+    
+    if (hinst == RT_NULL || send_buf == RT_NULL || send_len <= 0 || recv_buf == RT_NULL || recv_size <= 0)
+    {
+        LOG_E("rs485 send then recv dl fail. param is error.");
+        return(-RT_ERROR);
+    }
+    
+    send_iov.base = (void *)send_buf;
+    send_iov.len = send_len;
+    recv_iov.base = recv_buf;
+    recv_iov.len = recv_size;
+    
+    return(rs485_transferv_dl(hinst, &send_iov, 1, &recv_iov, 1, done, ctx, deadline));
+}
+
+#ifdef RS485_USING_RTO
+/* 
+ * @brief   send data to a peer and then receive its response, the response timeout is learned 
+ *          from the latency of the peer instead of the receive timeout of instance
+ * @param   hinst       - instance handle
+ * @param   peer        - peer id, such as slave address, >=0
+ * @param   send_buf    - send buffer addr
+ * @param   send_len    - length of send datas
+ * @param   recv_buf    - recv buffer addr
+ * @param   recv_size   - maximum length of received datas
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_send_then_recv_peer(rs485_inst_t * hinst, int peer, const void *send_buf, int send_len, 
+                                void *recv_buf, int recv_size)
+{
+    rs485_iovec_t send_iov, recv_iov;
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || peer < 0 || send_buf == RT_NULL || send_len <= 0 || recv_buf == RT_NULL || recv_size <= 0)
+    {
+        LOG_E("rs485 send then recv peer fail. param is error.");
+        return(-RT_ERROR);
+    }
+    
+    send_iov.base = (void *)send_buf;
+    send_iov.len = send_len;
+    recv_iov.base = recv_buf;
+    recv_iov.len = recv_size;
+    
+    rs485_wait_init(hinst, &w, 0, 0);
+    
+    return(rs485_transfer_segs(hinst, peer, &send_iov, 1, &recv_iov, 1, RT_NULL, RT_NULL, hinst->timeout, &w));
+}
+
+/* 
+ * @brief   send datas gathered from segments to a peer and then receive its response scattered into segments,
+ *          the response timeout is learned from the latency of the peer
+ * @param   hinst       - instance handle
+ * @param   peer        - peer id, such as slave address, >=0
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, >0
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_transferv_peer(rs485_inst_t * hinst, int peer, const rs485_iovec_t *send_iov, int send_cnt, 
+                        const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx)
 {
-    rs485_inst_t *hinst = (rs485_inst_t *)(dev->user_data);
-    if (hinst->evt)
+    struct rs485_wait w;
+    
+    if (hinst == RT_NULL || peer < 0 || rs485_iov_check(send_iov, send_cnt) == 0 || 
+        rs485_iov_check(recv_iov, recv_cnt) == 0)
     {
-        rt_event_send(hinst->evt, RS485_EVT_RX_IND);
+        LOG_E("rs485 transferv peer fail. param is error.");
+        return(-RT_ERROR);
     }
-    return(RT_EOK);
+
+    rs485_wait_init(hinst, &w, 0, 0);
+
+    return(rs485_transfer_segs(hinst, peer, send_iov, send_cnt, recv_iov, recv_cnt, done, ctx, hinst->timeout, &w));
 }
+#endif
 
-static int rs485_cal_byte_tmo(int baudrate)
+/* 
+ * @brief   run transactions back to back under one bus acquisition
+ * @param   hinst       - instance handle
+ * @param   xfers       - transactions array, result of each one is filled in
+ * @param   count       - count of transactions
+ * @retval  >=0 - count of transactions received response, <0 - error
+ */
+int rs485_transact_batch(rs485_inst_t * hinst, rs485_xfer_t *xfers, int count)
 {
-    int tmo = (40 * 1000) / baudrate;
-    if (tmo < RS485_BYTE_TMO_MIN)
+    int answered = 0;
+    struct rs485_wait w;
+    rt_err_t rc;
+    
+    if (hinst == RT_NULL || xfers == RT_NULL || count <= 0)
     {
-        tmo = RS485_BYTE_TMO_MIN;
+        LOG_E("rs485 transact batch fail. param is error.");
+        return(-RT_ERROR);
     }
-    else if (tmo > RS485_BYTE_TMO_MAX)
+
+    if (hinst->status == 0)
     {
-        tmo = RS485_BYTE_TMO_MAX;
+        LOG_E("rs485 transact batch fail. it is not connected.");
+        return(-RT_ERROR);
     }
-    return (tmo);
+
+    rs485_wait_init(hinst, &w, 0, 0);
+    rc = rs485_bus_wait(hinst, &w);
+    if (rc != RT_EOK)
+    {
+        if (rc != -RT_EINTR)
+        {
+            LOG_E("rs485 transact batch fail. it is destoried.");
+            rc = -RT_ERROR;
+        }
+        return(rc);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        rs485_xfer_t *x = &xfers[i];
+        rt_uint32_t start;
+        int len;
+        
+        if (x->send_buf == RT_NULL || x->send_len <= 0 || (x->recv_size > 0 && x->recv_buf == RT_NULL))
+        {
+            x->result = -RT_EINVAL;
+            continue;
+        }
+        
+        rs485_rx_flush(hinst);
+        start = rs485_get_us();
+        len = rs485_send_datas(hinst, x->send_buf, x->send_len, &w);
+        if (len != x->send_len)
+        {
+            x->result = (len == -RT_EINTR) ? len : -RT_EIO;
+        }
+        else if (x->recv_size <= 0)//broadcast, no response
+        {
+            x->result = 0;
+        }
+        else
+        {
+            x->result = rs485_recv_datas(hinst, x->recv_buf, x->recv_size, 
+                                        (x->timeout > 0) ? rt_tick_from_millisecond(x->timeout) : hinst->timeout, 
+                                        RT_NULL, RT_NULL, &w);
+            if (x->result > 0)
+            {
+                RS485_STAT_XFER(hinst, start);
+                answered++;
+            }
+        }
+        if (x->result == -RT_EINTR)//cancelled in send or receive, the rest are not run
+        {
+            while (++i < count)
+            {
+                xfers[i].result = -RT_EINTR;
+            }
+        }
+    }
+    
+    rt_mutex_release(&hinst->lock);
+    
+    return(answered);
 }
 
-static void rs485_mode_set(rs485_inst_t * hinst, int mode)//mode : 0--receive mode, 1--send mode
+/* 
+ * @brief   set crc updated over received datas, it is calculated while the frame is arriving 
+ * @param   hinst       - instance handle
+ * @param   type        - crc type, RS485_CRC_NONE, RS485_CRC_16 or RS485_CRC_32
+ * @retval  0 - success, other - error
+ */
+int rs485_set_rx_crc(rs485_inst_t * hinst, int type)
 {
-    if (hinst->pin < 0)
+    if (hinst == RT_NULL || type < RS485_CRC_NONE || type > RS485_CRC_32)
     {
-        return;
+        LOG_E("rs485 set rx crc fail. param is error.");
+        return(-RT_ERROR);
     }
     
-    if (mode)
+    hinst->rx_crc_type = type;
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   get crc over the last received frame including its crc, the frame is valid 
+ *          when it equals RS485_CRC16_RESIDUE or RS485_CRC32_RESIDUE
+ * @param   hinst       - instance handle
+ * @retval  crc value
+ */
+rt_uint32_t rs485_get_rx_crc(rs485_inst_t * hinst)
+{
+    if (hinst == RT_NULL)
     {
-        rt_pin_write(hinst->pin, hinst->level);
+        return(0);
     }
-    else
+    
+    return(hinst->rx_crc);
+}
+
+/* 
+ * @brief   send datas gathered from segments to rs485 and then receive response scattered into segments,
+ *          the crc over the response is returned by the call, so it is not changed by other receivers 
+ *          of instance and the crc type of instance is kept
+ * @param   hinst       - instance handle
+ * @param   peer        - peer id the response timeout is learned for with RS485_USING_RTO, 
+ *                        <0--receive timeout of instance
+ * @param   send_iov    - send segments array
+ * @param   send_cnt    - count of send segments
+ * @param   recv_iov    - receive segments array
+ * @param   recv_cnt    - count of receive segments, >0
+ * @param   done        - frame completed predicate, NULL--wait the frame gap
+ * @param   ctx         - context passed to predicate
+ * @param   crc_type    - crc type of this response, RS485_CRC_16 or RS485_CRC_32
+ * @param   crc         - output, crc over the response including its crc, the response is valid 
+ *                        when it equals RS485_CRC16_RESIDUE or RS485_CRC32_RESIDUE
+ * @retval  >=0 - length of received datas, <0 - error
+ */
+int rs485_transferv_crc(rs485_inst_t * hinst, int peer, const rs485_iovec_t *send_iov, int send_cnt, 
+                        const rs485_iovec_t *recv_iov, int recv_cnt, rs485_frame_done_t done, void *ctx, 
+                        int crc_type, rt_uint32_t *crc)
+{
+    struct rs485_wait w;
+    int recv_len;
+    
+    if (hinst == RT_NULL || rs485_iov_check(send_iov, send_cnt) == 0 || rs485_iov_check(recv_iov, recv_cnt) == 0 || 
+        crc_type < RS485_CRC_16 || crc_type > RS485_CRC_32 || crc == RT_NULL)
     {
-        rt_pin_write(hinst->pin, ! hinst->level);
+        LOG_E("rs485 transferv crc fail. param is error.");
+        return(-RT_ERROR);
     }
 
-    #if (RS485_SW_DLY_US > 0)
-    rt_hw_us_delay(RS485_SW_DLY_US);
-    #endif
+    rs485_wait_init(hinst, &w, 0, 0);
+    w.crc_type = crc_type;
+    
+    recv_len = rs485_transfer_segs(hinst, peer, send_iov, send_cnt, recv_iov, recv_cnt, done, ctx, hinst->timeout, &w);
+    *crc = w.crc;
+    
+    return(recv_len);
 }
 
+#ifdef RS485_USING_STATS
 /* 
- * @brief   create rs485 instance dynamically
- * @param   serial      - serial device name
- * @param   baudrate    - serial baud rate
- * @param   parity      - serial parity mode
- * @param   pin         - mode contrle pin
- * @param   level       - send mode level
- * @retval  instance handle
+ * @brief   get performance counters of instance
+ * @param   hinst       - instance handle
+ * @param   stats       - output, copy of counters
+ * @retval  0 - success, other - error
  */
-rs485_inst_t * rs485_create(const char *name, int baudrate, int parity, int pin, int level)
+int rs485_get_stats(rs485_inst_t * hinst, rs485_stats_t *stats)
 {
-    rs485_inst_t *hinst;
-    rt_device_t dev;
+    rt_base_t level;
     
-    dev = rt_device_find(name);
-    if (dev == RT_NULL)
+    if (hinst == RT_NULL || stats == RT_NULL)
     {
-        LOG_E("rs485 instance initiliaze error, the serial device(%s) no found.", name);
-        return(RT_NULL);
+        LOG_E("rs485 get stats fail. param is error.");
+        return(-RT_ERROR);
     }
     
-    if (dev->type != RT_Device_Class_Char)
-    {
-        LOG_E("rs485 instance initiliaze error, the serial device(%s) type is not char.", name);
-        return(RT_NULL);
-    }
+    level = rt_hw_interrupt_disable();
+    *stats = hinst->stats;
+    rt_hw_interrupt_enable(level);
+    
+    stats->xfer_avg_us = stats->xfer_count ? (rt_uint32_t)(stats->xfer_sum_us / stats->xfer_count) : 0;
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   clear performance counters of instance
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_reset_stats(rs485_inst_t * hinst)
+{
+    rt_base_t level;
     
-    hinst = rt_malloc(sizeof(struct rs485_inst));
     if (hinst == RT_NULL)
     {
-        LOG_E("rs485 create fail. no memory for rs485 create instance.");
-        return(RT_NULL);
+        LOG_E("rs485 reset stats fail. hinst is NULL.");
+        return(-RT_ERROR);
     }
+    
+    level = rt_hw_interrupt_disable();
+    rt_memset(&hinst->stats, 0, sizeof(hinst->stats));
+    rt_hw_interrupt_enable(level);
+    
+    return(RT_EOK);
+}
+#endif
 
-    hinst->lock = rt_mutex_create(name, RT_IPC_FLAG_FIFO);
-    if (hinst->lock == RT_NULL)
+#ifdef RS485_USING_TRACE
+/* 
+ * @brief   get the newest entries of trace ring
+ * @param   hinst       - instance handle
+ * @param   entries     - output, entries from the oldest to the newest
+ * @param   num         - maximum count of entries
+ * @retval  >=0 - count of entries, <0 - error
+ */
+int rs485_get_trace(rs485_inst_t * hinst, rs485_trace_t *entries, int num)
+{
+    rt_uint32_t head;
+    int cnt;
+    
+    if (hinst == RT_NULL || entries == RT_NULL || num < 0)
     {
-        rt_free(hinst);
-        LOG_E("rs485 create fail. no memory for rs485 create mutex.");
-        return(RT_NULL);
+        LOG_E("rs485 get trace fail. param is error.");
+        return(-RT_ERROR);
     }
-
-    hinst->evt = rt_event_create(name, RT_IPC_FLAG_FIFO);
-    if (hinst->evt == RT_NULL)
+    
+    head = hinst->trace_head;
+    cnt = (head < RS485_TRACE_NUM) ? (int)head : RS485_TRACE_NUM;
+    if (cnt > num)
     {
-        rt_mutex_delete(hinst->lock);
-        rt_free(hinst);
-        LOG_E("rs485 create fail. no memory for rs485 create event.");
-        return(RT_NULL);
+        cnt = num;
     }
-
-    hinst->serial = dev;
-    hinst->status = 0;
-    hinst->pin = pin;
-    hinst->level = (level != 0);
-    hinst->timeout = 0;
-    hinst->byte_tmo = rs485_cal_byte_tmo(baudrate);
     
-    rs485_config(hinst, baudrate, 8, parity, 0);
-
-    LOG_D("rs485 create success.");
-
-    return(hinst);
+    for (int i = 0; i < cnt; i++)//an entry being recorded meanwhile may be read half updated
+    {
+        entries[i] = hinst->trace[(head - cnt + i) & (RS485_TRACE_NUM - 1)];
+    }
+    
+    return(cnt);
 }
 
 /* 
- * @brief   destory rs485 instance created dynamically
+ * @brief   clear trace ring of instance
  * @param   hinst       - instance handle
  * @retval  0 - success, other - error
  */
-int rs485_destory(rs485_inst_t * hinst)
+int rs485_clear_trace(rs485_inst_t * hinst)
 {
     if (hinst == RT_NULL)
     {
-        LOG_E("rs485 destory fail. hinst is NULL.");
+        LOG_E("rs485 clear trace fail. hinst is NULL.");
         return(-RT_ERROR);
     }
     
-    rs485_disconn(hinst);
+    hinst->trace_head = 0;
+    
+    return(RT_EOK);
+}
+#endif
 
-    if (hinst->lock)
+#ifdef RS485_USING_RTO
+/* 
+ * @brief   set floor and ceiling of learned response timeout, the learned values are cleared
+ * @param   hinst       - instance handle
+ * @param   min_ms      - floor, ms, 0--RS485_RTO_MIN
+ * @param   max_ms      - ceiling, ms, 0--RS485_RTO_MAX
+ * @retval  0 - success, other - error
+ */
+int rs485_set_rto(rs485_inst_t * hinst, int min_ms, int max_ms)
+{
+    if (min_ms == 0)
     {
-        rt_mutex_delete(hinst->lock);
-        hinst->lock = RT_NULL;
+        min_ms = RS485_RTO_MIN;
     }
-
-    if (hinst->evt)
+    if (max_ms == 0)
     {
-        rt_event_delete(hinst->evt);
-        hinst->evt = RT_NULL;
+        max_ms = RS485_RTO_MAX;
     }
     
-    rt_free(hinst);
+    if (hinst == RT_NULL || min_ms < 0 || max_ms < min_ms || max_ms > 0xFFFF)
+    {
+        LOG_E("rs485 set rto fail. param is error.");
+        return(-RT_ERROR);
+    }
     
-    LOG_D("rs485 destory success.");
+    if (rs485_bus_take(hinst) != RT_EOK)
+    {
+        LOG_E("rs485 set rto fail. it is destoried.");
+        return(-RT_ERROR);
+    }
+    
+    hinst->rto_min = min_ms;
+    hinst->rto_max = max_ms;
+    rs485_rto_clear(hinst);
+    
+    rt_mutex_release(&hinst->lock);
     
     return(RT_EOK);
 }
 
 /* 
- * @brief   config rs485 params 
+ * @brief   get learned response timeouts of peers
  * @param   hinst       - instance handle
- * @param   baudrate    - baudrate of communication
- * @param   databits    - data bits, 5~8
- * @param   parity      - parity bit, 0~2, 0 - none, 1 - odd, 2 - even
- * @param   stopbits    - stop bits, 0~1, 0 - 1 stop bit, 1 - 2 stop bits
- * @retval  0 - success, other - error
+ * @param   entries     - output, learned values of peers
+ * @param   num         - maximum count of entries
+ * @retval  >=0 - count of entries, <0 - error
  */
-int rs485_config(rs485_inst_t * hinst, int baudrate, int databits, int parity, int stopbits)
+int rs485_get_rto(rs485_inst_t * hinst, rs485_rto_t *entries, int num)
 {
-    struct serial_configure config = RT_SERIAL_CONFIG_DEFAULT;
-
-    if (hinst == RT_NULL)
+    int cnt = 0;
+    
+    if (hinst == RT_NULL || entries == RT_NULL || num < 0)
     {
-        LOG_E("rs485 config fail. hinst is NULL.");
+        LOG_E("rs485 get rto fail. param is error.");
+        return(-RT_ERROR);
+    }
+    
+    if (rs485_bus_take(hinst) != RT_EOK)
+    {
+        LOG_E("rs485 get rto fail. it is destoried.");
         return(-RT_ERROR);
     }
+    
+    for (int i = 0; i < RS485_RTO_PEERS && cnt < num; i++)
+    {
+        if (hinst->rto[i].peer >= 0)
+        {
+            entries[cnt++] = hinst->rto[i];
+        }
+    }
+    
+    rt_mutex_release(&hinst->lock);
+    
+    return(cnt);
+}
+#endif
 
-    hinst->byte_tmo = rs485_cal_byte_tmo(baudrate);
+#ifdef RS485_USING_FRAME_POOL
+static rs485_frame_t * rs485_frame_alloc(rs485_inst_t * hinst)
+{
+    rs485_frame_t *frame = RT_NULL;
+    rt_base_t level = rt_hw_interrupt_disable();
+    
+    for (int i = 0; i < RS485_FRAME_POOL_NUM; i++)
+    {
+        if (hinst->frame_free & (1UL << i))
+        {
+            hinst->frame_free &= ~(1UL << i);
+            frame = &hinst->frames[i];
+            break;
+        }
+    }
+    
+    rt_hw_interrupt_enable(level);
+    
+    return(frame);
+}
 
-    config.baud_rate = baudrate;
-    config.data_bits = databits;
-    config.parity = parity;
-    config.stop_bits = stopbits;
-    rt_device_control(hinst->serial, RT_DEVICE_CTRL_CONFIG, &config);
+/* 
+ * @brief   receive a frame into the frame pool of instance
+ * @param   hinst       - instance handle
+ * @param   frame       - output, the received frame, release it by rs485_frame_release after used
+ * @retval  >0 - length of received frame, 0 - timeout, <0 - error
+ */
+int rs485_recv_frame(rs485_inst_t * hinst, rs485_frame_t ** frame)
+{
+    rs485_frame_t *fr;
+    struct rs485_wait w;
+    int recv_len = 0;
+    
+    if (hinst == RT_NULL || frame == RT_NULL)
+    {
+        LOG_E("rs485 receive frame fail. param error.");
+        return(-RT_ERROR);
+    }
+    
+    *frame = RT_NULL;
+    
+    if (hinst->status == 0)
+    {
+        LOG_E("rs485 receive frame fail. it is not connected.");
+        return(-RT_ERROR);
+    }
+    
+    fr = rs485_frame_alloc(hinst);
+    if (fr == RT_NULL)
+    {
+        LOG_W("rs485 receive frame fail. no free frame in pool.");
+        return(-RT_EFULL);
+    }
+    
+    rs485_wait_init(hinst, &w, 0, 0);
+    recv_len = rs485_recv_within(hinst, fr->data, RS485_FRAME_SIZE, RT_NULL, RT_NULL, hinst->timeout, &w);
+    
+    if (recv_len <= 0)
+    {
+        rs485_frame_release(hinst, fr);
+        return(recv_len);
+    }
+    
+    fr->len = recv_len;
+    *frame = fr;
+    
+    return(recv_len);
+}
 
+/* 
+ * @brief   release a frame back to the frame pool of instance
+ * @param   hinst       - instance handle
+ * @param   frame       - frame received by rs485_recv_frame
+ * @retval  0 - success, other - error
+ */
+int rs485_frame_release(rs485_inst_t * hinst, rs485_frame_t * frame)
+{
+    int index;
+    rt_base_t level;
+    
+    if (hinst == RT_NULL || frame == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+    
+    index = frame - hinst->frames;
+    if (index < 0 || index >= RS485_FRAME_POOL_NUM)
+    {
+        LOG_E("rs485 release frame fail. it is not in the frame pool.");
+        return(-RT_ERROR);
+    }
+    
+    frame->len = 0;
+    level = rt_hw_interrupt_disable();
+    hinst->frame_free |= (1UL << index);
+    rt_hw_interrupt_enable(level);
+    
     return(RT_EOK);
 }
+#endif
+
+#ifdef RS485_USING_FRAME_HANDLER
+/* insert timer into the list sorted by expire */
+static void rs485_loop_timer_insert(rs485_loop_t *loop, rs485_loop_timer_t *timer, rt_tick_t expire)
+{
+    rs485_loop_timer_t **pp = &loop->timers;
+    
+    while (*pp != RT_NULL && (rt_int32_t)((*pp)->expire - expire) <= 0)
+    {
+        pp = &(*pp)->next;
+    }
+    timer->expire = expire;
+    timer->next = *pp;
+    *pp = timer;
+    timer->active = 1;
+}
+
+static void rs485_loop_timer_remove(rs485_loop_t *loop, rs485_loop_timer_t *timer)
+{
+    if ( ! timer->active)
+    {
+        return;
+    }
+    for (rs485_loop_timer_t **pp = &loop->timers; *pp != RT_NULL; pp = &(*pp)->next)
+    {
+        if (*pp == timer)
+        {
+            *pp = timer->next;
+            break;
+        }
+    }
+    timer->active = 0;
+}
 
-/* 
- * @brief   set wait datas timeout for receiving 
- * @param   hinst       - instance handle
- * @param   tmo_ms      - receive wait timeout, 0--no wait, <0--wait forever, >0--wait timeout, default = 0
- * @retval  0 - success, other - error
- */
-int rs485_set_recv_tmo(rs485_inst_t * hinst, int tmo_ms)
+/* read pending datas of the frame being assembled, dispatch it when completed, 
+   returns microseconds left of frame gap, -1--no frame being assembled */
+static int rs485_worker_poll(rs485_inst_t * hinst)
 {
-    if (hinst == RT_NULL)
+    rt_uint32_t elapsed;
+    
+    if (hinst->status == 0)
     {
-        LOG_E("rs485 set recv timeout fail. hinst is NULL.");
-        return(-RT_ERROR);
+        return(-1);
     }
     
-    hinst->timeout = tmo_ms;
+    rs485_bus_take(hinst);
+    while (hinst->asm_len < RS485_FRAME_SIZE)
+    {
+        int len = rs485_rx_read(hinst, hinst->asm_buf + hinst->asm_len, RS485_FRAME_SIZE - hinst->asm_len);
+        if (len == 0)
+        {
+            break;
+        }
+        if (hinst->asm_len == 0)
+        {
+            rs485_rx_crc_reset(hinst->rx_crc_type, &hinst->asm_crc);
+        }
+        rs485_rx_crc_update(hinst->rx_crc_type, &hinst->asm_crc, hinst->asm_buf + hinst->asm_len, len);
+        hinst->asm_len += len;
+    }
+    rt_mutex_release(&hinst->lock);
     
-    LOG_D("rs485 set recv timeout success. the value is %d.", tmo_ms);
-
-    return(RT_EOK);
-}
- 
-/* 
- * @brief   set byte interval timeout for receiving
- * @param   hinst       - instance handle
- * @param   tmo_ms      - byte interval timeout, default is calculated from baudrate
- * @retval  0 - success, other - error
- */
-int rs485_set_byte_tmo(rs485_inst_t * hinst, int tmo_ms)
-{
-    if (hinst == RT_NULL)
+    if (hinst->asm_len == 0)
     {
-        LOG_E("rs485 set byte timeout fail. hinst is NULL.");
-        return(-RT_ERROR);
+        return(-1);
     }
     
-    if (tmo_ms < RS485_BYTE_TMO_MIN)
+    if (hinst->asm_len < RS485_FRAME_SIZE)
     {
-        tmo_ms = RS485_BYTE_TMO_MIN;
+        if ((hinst->flags & RS485_CONN_IDLE_END) == 0)//else the idle line of dma receive ended the frame
+        {
+            rt_uint32_t gap = rs485_gap_us(hinst);
+            elapsed = rs485_get_us() - hinst->rx_stamp;
+            if (elapsed < gap)
+            {
+                return(gap - elapsed);
+            }
+        }
+        RS485_STAT_ADD(hinst, rx_gap_ends, 1);
     }
-    else if (tmo_ms > RS485_BYTE_TMO_MAX)
+    RS485_STAT_ADD(hinst, rx_bytes, hinst->asm_len);
+    RS485_STAT_ADD(hinst, rx_frames, 1);
+#ifdef RS485_USING_TRACE
     {
-        tmo_ms = RS485_BYTE_TMO_MAX;
+        rs485_iovec_t iov = {hinst->asm_buf, hinst->asm_len};
+        rs485_trace_put(hinst, RS485_TRACE_RX, &iov, 1, hinst->asm_len, RT_EOK);
     }
+#endif
+    hinst->rx_crc = hinst->asm_crc;//rs485_get_rx_crc of handler
+    hinst->handler(hinst, hinst->asm_buf, hinst->asm_len, hinst->handler_ctx);
+    hinst->asm_len = 0;
     
-    hinst->byte_tmo = tmo_ms;
+    return(-1);
+}
 
-    LOG_D("rs485 set byte timeout success. the value is %d.", tmo_ms);
+/* remove expired timers and call them, returns ticks to next expire, RT_WAITING_FOREVER--no timer */
+static rt_int32_t rs485_loop_timers(rs485_loop_t *loop)
+{
+    rs485_loop_timer_t *t;
+    
+    while ((t = loop->timers) != RT_NULL)
+    {
+        rt_int32_t left = (rt_int32_t)(t->expire - rt_tick_get());
+        if (left > 0)
+        {
+            return(left);
+        }
+        loop->timers = t->next;
+        t->active = 0;
+        if (t->period)
+        {
+            rs485_loop_timer_insert(loop, t, t->expire + t->period);
+        }
+        t->cb(t, t->ctx);//the list is read again, the callback can change it
+    }
+    
+    return(RT_WAITING_FOREVER);
+}
 
-    return(RT_EOK);
+static void rs485_loop_entry(void *args)
+{
+    rs485_loop_t *loop = (rs485_loop_t *)args;
+    rt_int32_t tmo = RT_WAITING_FOREVER;
+    
+    while (1)
+    {
+        rt_uint32_t recved = 0;
+        rt_int32_t tick_left;
+        int min_left = -1;
+        
+        if (tmo != 0)
+        {
+            rt_event_recv(&loop->evt, 0xFFFFFFFF, (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), tmo, &recved);
+        }
+        
+        rt_mutex_take(&loop->lock, RT_WAITING_FOREVER);
+        for (rs485_inst_t *hinst = loop->insts; hinst != RT_NULL; hinst = hinst->loop_next)
+        {
+            int left;
+            if ((hinst->asm_len == 0) && ((recved & hinst->loop_bit) == 0))//idle instance, no datas indicated
+            {
+                continue;
+            }
+            left = rs485_worker_poll(hinst);
+            if (left >= 0 && (min_left < 0 || left < min_left))
+            {
+                min_left = left;
+            }
+        }
+        tick_left = rs485_loop_timers(loop);
+        rt_mutex_release(&loop->lock);
+        
+        if (min_left < 0)//no frame being assembled
+        {
+            tmo = tick_left;
+        }
+        else//sleep the rest of gap rounded up to whole ticks, new datas wake up early
+        {
+            tmo = (min_left + RS485_TICK_US - 1) / RS485_TICK_US;
+            if (tick_left >= 0 && tick_left < tmo)
+            {
+                tmo = tick_left;
+            }
+        }
+    }
 }
 
 /* 
- * @brief   open rs485 connect
- * @param   hinst       - instance handle
+ * @brief   initialize an event loop and start its thread, no heap is used
+ * @param   loop        - loop to initialize, global or static storage
+ * @param   name        - name of loop thread
+ * @param   stack       - stack of loop thread
+ * @param   stack_size  - stack size
+ * @param   priority    - priority of loop thread
  * @retval  0 - success, other - error
  */
-int rs485_connect(rs485_inst_t * hinst)
+int rs485_loop_init(rs485_loop_t *loop, const char *name, void *stack, int stack_size, int priority)
 {
-    if (hinst == RT_NULL)
+    if (loop == RT_NULL || name == RT_NULL || stack == RT_NULL || stack_size <= 0)
     {
-        LOG_E("rs485 connect fail. hinst is NULL.");
+        LOG_E("rs485 loop init fail. param is error.");
         return(-RT_ERROR);
     }
-
-    if (hinst->status == 1)//is connected
-    {
-        LOG_D("rs485 is connected.");
-        return(RT_EOK);
-    }
     
-    if ( rt_device_open(hinst->serial, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_INT_RX) != RT_EOK)
+    rt_mutex_init(&loop->lock, name, RT_IPC_FLAG_FIFO);
+    rt_event_init(&loop->evt, name, RT_IPC_FLAG_FIFO);
+    loop->insts = RT_NULL;
+    loop->timers = RT_NULL;
+    loop->next_bit = 0;
+    if (rt_thread_init(&loop->thread, name, rs485_loop_entry, loop, 
+                        stack, stack_size, priority, 20) != RT_EOK)
     {
-        LOG_E("rs485 instance connect error. serial open fail.");
+        rt_event_detach(&loop->evt);
+        rt_mutex_detach(&loop->lock);
+        LOG_E("rs485 loop init fail. init loop thread error.");
         return(-RT_ERROR);
     }
+    rt_thread_startup(&loop->thread);
     
-    if (hinst->pin >= 0)
-    {
-        rt_pin_mode(hinst->pin, PIN_MODE_OUTPUT);
-        rt_pin_write(hinst->pin, ! hinst->level);
-    }
-
-
-    hinst->serial->user_data = hinst;
-    hinst->serial->rx_indicate = rs485_recv_ind_hook;
-    hinst->status = 1;
-
-    LOG_D("rs485 connect success.");
-
     return(RT_EOK);
 }
 
 /* 
- * @brief   close rs485 connect
+ * @brief   register instance in event loop, the loop thread owns reception of the instance
+ *          and calls the handler once for each completed frame, any number of instances can be registered
+ * @param   loop        - loop handle
  * @param   hinst       - instance handle
+ * @param   handler     - frame handler
+ * @param   ctx         - context passed to handler
  * @retval  0 - success, other - error
  */
-int rs485_disconn(rs485_inst_t * hinst)
+int rs485_loop_add(rs485_loop_t *loop, rs485_inst_t * hinst, rs485_frame_handler_t handler, void *ctx)
 {
-    if (hinst == RT_NULL)
+    if (loop == RT_NULL || hinst == RT_NULL || handler == RT_NULL)
     {
-        LOG_E("rs485 disconnect fail. hinst is NULL.");
+        LOG_E("rs485 loop add fail. param is error.");
         return(-RT_ERROR);
     }
     
-    if (hinst->status == 0)//is not connected
-    {
-        LOG_D("rs485 is not connected.");
-        return(RT_EOK);
-    }
-
-    rt_mutex_take(hinst->lock, RT_WAITING_FOREVER);
-
-    if (hinst->serial)
+    if (hinst->loop != RT_NULL && hinst->loop != loop)
     {
-        hinst->serial->rx_indicate = RT_NULL;
-        rt_device_close(hinst->serial);
+        LOG_E("rs485 loop add fail. it is registered in another loop.");
+        return(-RT_EBUSY);
     }
     
-    if (hinst->pin >= 0)
+    rt_mutex_take(&loop->lock, RT_WAITING_FOREVER);
+    
+    hinst->handler = handler;
+    hinst->handler_ctx = ctx;
+    if (hinst->loop == RT_NULL)
     {
-        rt_pin_mode(hinst->pin, PIN_MODE_INPUT);
+        hinst->asm_len = 0;
+        hinst->loop_bit = (1UL << loop->next_bit);
+        loop->next_bit = (loop->next_bit + 1) % RS485_LOOP_BITS;
+        hinst->loop_next = loop->insts;
+        loop->insts = hinst;
+        hinst->loop = loop;
+        rt_event_send(&loop->evt, hinst->loop_bit);//pick up datas received before
     }
     
-    hinst->status = 0;
-    
-    rt_mutex_release(hinst->lock);
+    rt_mutex_release(&loop->lock);
     
-    LOG_D("rs485 disconnect success.");
+    LOG_D("rs485 loop add success.");
     
     return(RT_EOK);
 }
 
 /* 
- * @brief   receive datas from rs485
+ * @brief   unregister instance from its event loop
  * @param   hinst       - instance handle
- * @param   buf         - buffer addr
- * @param   size        - maximum length of received datas
- * @retval  >=0 - length of received datas, <0 - error
+ * @retval  0 - success, other - error
  */
-int rs485_recv(rs485_inst_t * hinst, void *buf, int size)
+int rs485_loop_remove(rs485_inst_t * hinst)
 {
-    int recv_len = 0;
-    rt_uint32_t recved = 0;
+    rs485_loop_t *loop;
     
-    if (hinst == RT_NULL || buf == RT_NULL || size == 0)
+    if (hinst == RT_NULL)
     {
-        LOG_E("rs485 receive fail. param error.");
+        LOG_E("rs485 loop remove fail. hinst is NULL.");
         return(-RT_ERROR);
     }
     
-    if (hinst->status == 0)
+    loop = hinst->loop;
+    if (loop == RT_NULL)
     {
-        LOG_E("rs485 receive fail. it is not connected.");
-        return(-RT_ERROR);
+        return(RT_EOK);
     }
     
-    if (rt_mutex_take(hinst->lock, RT_WAITING_FOREVER) != RT_EOK)
-    {
-        LOG_E("rs485 receive fail. it is destoried.");
-        return(-RT_ERROR);
-    }
+    rt_mutex_take(&loop->lock, RT_WAITING_FOREVER);
     
-    while(size)
+    for (rs485_inst_t **pp = &loop->insts; *pp != RT_NULL; pp = &(*pp)->loop_next)
     {
-        int len = rt_device_read(hinst->serial, 0, (char *)buf + recv_len, size);
-        if (len)
-        {
-            recv_len += len;
-            size -= len;
-            continue;
-        }
-        rt_event_control(hinst->evt, RT_IPC_CMD_RESET, RT_NULL);
-        if (recv_len)
-        {
-            if (rt_event_recv(hinst->evt, RS485_EVT_RX_IND, 
-                    (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), hinst->byte_tmo, &recved) != RT_EOK)
-            {
-                break;
-            }
-        }
-        else
+        if (*pp == hinst)
         {
-            if (rt_event_recv(hinst->evt, (RS485_EVT_RX_IND | RS485_EVT_RX_BREAK), 
-                    (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), hinst->timeout, &recved) != RT_EOK)
-            {
-                break;
-            }
-            if ((recved & RS485_EVT_RX_BREAK) != 0)
-            {
-                rt_mutex_release(hinst->lock);
-                rt_thread_delay(2);
-                return(0);
-            }
+            *pp = hinst->loop_next;
+            break;
         }
     }
+    hinst->loop = RT_NULL;
+    hinst->loop_next = RT_NULL;
+    hinst->handler = RT_NULL;
+    hinst->handler_ctx = RT_NULL;
     
-    rt_mutex_release(hinst->lock);
+    rt_mutex_release(&loop->lock);
     
-    return(recv_len);
+    LOG_D("rs485 loop remove success.");
+    
+    return(RT_EOK);
 }
 
 /* 
- * @brief   send datas to rs485
- * @param   hinst       - instance handle
- * @param   buf         - buffer addr
- * @param   size        - length of send datas
- * @retval  >=0 - length of sent datas, <0 - error
+ * @brief   start a timer dispatched by event loop thread, a started timer is restarted
+ * @param   loop        - loop handle
+ * @param   timer       - timer, global or static storage
+ * @param   cb          - callback
+ * @param   ctx         - context passed to callback
+ * @param   tmo_ms      - timeout, ms
+ * @param   periodic    - 0--one shot, 1--periodic
+ * @retval  0 - success, other - error
  */
-int rs485_send(rs485_inst_t * hinst, void *buf, int size)
+int rs485_loop_timer_start(rs485_loop_t *loop, rs485_loop_timer_t *timer, rs485_loop_timer_cb_t cb, void *ctx, 
+                            int tmo_ms, int periodic)
 {
-    int send_len = 0;
+    rt_tick_t tick;
     
-    if (hinst == RT_NULL || buf == RT_NULL || size == 0)
-    {
-        LOG_E("rs485 send fail. param is error.");
-        return(-RT_ERROR);
-    }
-
-    if (hinst->status == 0)
+    if (loop == RT_NULL || timer == RT_NULL || cb == RT_NULL || tmo_ms <= 0)
     {
-        LOG_E("rs485 send fail. it is not connected.");
+        LOG_E("rs485 loop timer start fail. param is error.");
         return(-RT_ERROR);
     }
     
-    if (rt_mutex_take(hinst->lock, RT_WAITING_FOREVER) != RT_EOK)
+    tick = rt_tick_from_millisecond(tmo_ms);
+    if (tick == 0)
     {
-        LOG_E("rs485 send fail. it is destoried.");
-        return(-RT_ERROR);
+        tick = 1;
     }
-
-    rs485_mode_set(hinst, 1);//set to send mode
-
-    send_len = rt_device_write(hinst->serial, 0, buf, size);
     
-    rs485_mode_set(hinst, 0);//set to receive mode
+    rt_mutex_take(&loop->lock, RT_WAITING_FOREVER);
     
-    rt_mutex_release(hinst->lock);
-
-    return(send_len);
+    rs485_loop_timer_remove(loop, timer);
+    timer->cb = cb;
+    timer->ctx = ctx;
+    timer->period = periodic ? tick : 0;
+    rs485_loop_timer_insert(loop, timer, rt_tick_get() + tick);
+    
+    rt_mutex_release(&loop->lock);
+    
+    rt_event_send(&loop->evt, RS485_LOOP_EVT_WAKE);
+    
+    return(RT_EOK);
 }
 
 /* 
- * @brief   break rs485 receive wait
- * @param   hinst       - instance handle
+ * @brief   stop a timer of event loop
+ * @param   loop        - loop handle
+ * @param   timer       - timer
  * @retval  0 - success, other - error
  */
-int rs485_break_recv(rs485_inst_t * hinst)
+int rs485_loop_timer_stop(rs485_loop_t *loop, rs485_loop_timer_t *timer)
 {
-    if ((hinst == RT_NULL) || (hinst->evt == RT_NULL))
+    if (loop == RT_NULL || timer == RT_NULL)
     {
+        LOG_E("rs485 loop timer stop fail. param is error.");
         return(-RT_ERROR);
     }
-
-    rt_event_send(hinst->evt, RS485_EVT_RX_BREAK);
     
-    return (RT_EOK);
+    rt_mutex_take(&loop->lock, RT_WAITING_FOREVER);
+    rs485_loop_timer_remove(loop, timer);
+    rt_mutex_release(&loop->lock);
+    
+    return(RT_EOK);
 }
 
-/* 
- * @brief   send data to rs485 and then receive response data from rs485
- * @param   hinst       - instance handle
- * @param   send_buf    - send buffer addr
- * @param   send_len    - length of send datas
- * @param   recv_buf    - recv buffer addr
- * @param   recv_size   - maximum length of received datas
- * @retval  >=0 - length of received datas, <0 - error
- */
-int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, void *recv_buf, int recv_size)
+static int rs485_worker_start(void)
 {
-    int recv_len = 0;
-    rt_uint32_t recved = 0;
+    rt_base_t level;
     
-    if (hinst == RT_NULL || send_buf == RT_NULL || send_len == 0 || recv_buf == RT_NULL || recv_size == 0)
+    level = rt_hw_interrupt_disable();
+    if (rs485_worker.state != 0)
     {
-        LOG_E("rs485 send then recv fail. param is error.");
-        return(-RT_ERROR);
+        rt_hw_interrupt_enable(level);
+        while (rs485_worker.state == 1)//started by another thread
+        {
+            rt_thread_delay(1);
+        }
+        return((rs485_worker.state == 2) ? RT_EOK : -RT_ERROR);
     }
-
-    if (hinst->status == 0)
+    rs485_worker.state = 1;
+    rt_hw_interrupt_enable(level);
+    
+    if (rs485_loop_init(&rs485_worker.loop, "rs485w", rs485_worker.stack, sizeof(rs485_worker.stack), 
+                        RS485_WORKER_PRIORITY) != RT_EOK)
     {
-        LOG_E("rs485 send_then_recv fail. it is not connected.");
+        rs485_worker.state = 0;
+        LOG_E("rs485 worker start fail. init default loop error.");
         return(-RT_ERROR);
     }
+    rs485_worker.state = 2;
+    
+    return(RT_EOK);
+}
 
-    if (rt_mutex_take(hinst->lock, RT_WAITING_FOREVER) != RT_EOK)
+/* 
+ * @brief   set frame handler, the default event loop thread owns reception of the instance
+ *          and calls the handler once for each completed frame
+ * @param   hinst       - instance handle
+ * @param   handler     - frame handler, NULL--remove handler
+ * @param   ctx         - context passed to handler
+ * @retval  0 - success, other - error
+ */
+int rs485_set_frame_handler(rs485_inst_t * hinst, rs485_frame_handler_t handler, void *ctx)
+{
+    if (hinst == RT_NULL)
     {
-        LOG_E("rs485 send_then_recv fail. it is destoried.");
+        LOG_E("rs485 set frame handler fail. hinst is NULL.");
         return(-RT_ERROR);
     }
-
-    rs485_mode_set(hinst, 1);//set to send mode
-    send_len = rt_device_write(hinst->serial, 0, send_buf, send_len);
-    rs485_mode_set(hinst, 0);//set to receive mode
-    if (send_len < 0)
+    
+    if (handler == RT_NULL)//remove
     {
-        rt_mutex_release(hinst->lock);
-        LOG_E("rs485 send_then_recv fail. send datas error.");
-        return(-RT_ERROR);
+        return(rs485_loop_remove(hinst));
     }
-
-    while(recv_size)
+    
+    if (rs485_worker_start() != RT_EOK)
     {
-        int len = rt_device_read(hinst->serial, 0, (char *)recv_buf + recv_len, recv_size);
-        if (len)
-        {
-            recv_len += len;
-            recv_size -= len;
-            continue;
-        }
-        rt_event_control(hinst->evt, RT_IPC_CMD_RESET, RT_NULL);
-        if (recv_len)
-        {
-            if (rt_event_recv(hinst->evt, RS485_EVT_RX_IND, 
-                    (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), hinst->byte_tmo, &recved) != RT_EOK)
-            {
-                break;
-            }
-        }
-        else
-        {
-            if (rt_event_recv(hinst->evt, RS485_EVT_RX_IND, 
-                    (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), hinst->timeout, &recved) != RT_EOK)
-            {
-                break;
-            }
-        }
+        return(-RT_ERROR);
     }
     
-    rt_mutex_release(hinst->lock);
-    
-    return(recv_len);
+    return(rs485_loop_add(&rs485_worker.loop, hinst, handler, ctx));
 }
-
+#endif
@@ -0,0 +1,685 @@
+/*
+ * rs485_modbus.c
+ *
+ * modbus rtu master on rs485 instance
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       check response crc while receiving
+ * 2026-10-17     qiyongzhong       complete exception response without waiting frame gap
+ * 2026-10-17     qiyongzhong       wait response by learned timeout of slave
+ * 2026-10-17     qiyongzhong       see exception in response head only
+ * 2026-10-17     qiyongzhong       check response crc returned by the transaction
+ */
+
+#include <rtthread.h>
+#include <rs485.h>
+#include <rs485_modbus.h>
+#include <rs485_crc.h>
+
+#define DBG_TAG "rs485.modbus"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#ifdef RS485_USING_MODBUS
+
+#define RS485_MB_EX_RSP_LEN     5       //length of exception response
+
+/* 
+ * @brief   calculate modbus crc16
+ * @param   crc         - initial value, 0xFFFF for a new frame, or the result of last part
+ * @param   buf         - datas addr
+ * @param   len         - length of datas
+ * @retval  crc value, low byte is sent first
+ */
+rt_uint16_t rs485_mb_crc16(rt_uint16_t crc, const void *buf, int len)
+{
+    return(rs485_crc16(crc, buf, len));
+}
+
+static int rs485_mb_put16(rt_uint8_t *p, rt_uint16_t v)
+{
+    p[0] = (rt_uint8_t)(v >> 8);
+    p[1] = (rt_uint8_t)(v);
+    return(2);
+}
+
+static rt_uint16_t rs485_mb_get16(const rt_uint8_t *p)
+{
+    return((rt_uint16_t)((p[0] << 8) | p[1]));
+}
+
+/* registers are received in wire order, convert them to cpu order in place */
+static void rs485_mb_regs_in(rt_uint16_t *regs, int num)
+{
+    rt_uint8_t *p = (rt_uint8_t *)regs;
+    
+    for (int i = 0; i < num; i++, p += 2)
+    {
+        regs[i] = rs485_mb_get16(p);
+    }
+}
+
+/* read a byte at pos of the received segments */
+static rt_uint8_t rs485_mb_seg_byte(const rs485_iovec_t *iov, int pos)
+{
+    while (pos >= iov->len)
+    {
+        pos -= iov->len;
+        iov++;
+    }
+    return(((rt_uint8_t *)iov->base)[pos]);
+}
+
+/* an exception response is completed at its last byte, it is seen in the function code of response head,
+   a normal one when the segments are filled */
+static int rs485_mb_rsp_done(const rt_uint8_t *buf, int len, void *ctx)
+{
+    return((len >= 2 && (buf[1] & 0x80) != 0) ? RS485_MB_EX_RSP_LEN : 0);
+}
+
+/* a response with byte count is completed at its last byte */
+static int rs485_mb_count_rsp_done(const rt_uint8_t *buf, int len, void *ctx)
+{
+    if (len >= 2 && (buf[1] & 0x80) != 0)
+    {
+        return(rs485_mb_rsp_done(buf, len, ctx));
+    }
+    
+    return((len >= 3 && len >= 3 + buf[2] + 2) ? 3 + buf[2] + 2 : 0);
+}
+
+/* send the request and receive the response into segments, 
+   the request buffer should have 2 bytes room for crc, the response segments end with crc */
+static int rs485_mb_transact(rs485_inst_t * hinst, rt_uint8_t *req, int req_len, 
+                                const rs485_iovec_t *rsp, int rsp_cnt)
+{
+    rs485_iovec_t send_iov;
+    rt_uint8_t slave = req[0];
+    rt_uint8_t func = req[1];
+    rt_uint16_t crc;
+    rt_uint32_t rx_crc;
+    int expect = 0;
+    int len;
+    
+    crc = rs485_mb_crc16(0xFFFF, req, req_len);
+    req[req_len++] = (rt_uint8_t)(crc);
+    req[req_len++] = (rt_uint8_t)(crc >> 8);
+    send_iov.base = req;
+    send_iov.len = req_len;
+    
+    if (slave == 0)//broadcast, no response
+    {
+        len = rs485_transferv(hinst, &send_iov, 1, RT_NULL, 0);
+        return(len < 0 ? len : RT_EOK);
+    }
+    
+    for (int i = 0; i < rsp_cnt; i++)
+    {
+        expect += rsp[i].len;
+    }
+    
+    //checked while the response is arriving, the timeout is learned for the slave with RS485_USING_RTO
+    len = rs485_transferv_crc(hinst, slave, &send_iov, 1, rsp, rsp_cnt, rs485_mb_rsp_done, RT_NULL, RS485_CRC_16, &rx_crc);
+    if (len < 0)
+    {
+        return(len);
+    }
+    if (len == 0)
+    {
+        LOG_D("rs485 modbus slave %d function 0x%02X no response.", slave, func);
+        return(-RT_ETIMEOUT);
+    }
+    
+    if (len == RS485_MB_EX_RSP_LEN && rs485_mb_seg_byte(rsp, 1) == (func | 0x80))
+    {
+        if (rx_crc != RS485_CRC16_RESIDUE || rs485_mb_seg_byte(rsp, 0) != slave)
+        {
+            return(-RT_EIO);
+        }
+        LOG_D("rs485 modbus slave %d function 0x%02X exception 0x%02X.", slave, func, rs485_mb_seg_byte(rsp, 2));
+        return(rs485_mb_seg_byte(rsp, 2));
+    }
+    
+    if (len != expect || rx_crc != RS485_CRC16_RESIDUE || 
+        rs485_mb_seg_byte(rsp, 0) != slave || rs485_mb_seg_byte(rsp, 1) != func)
+    {
+        LOG_D("rs485 modbus slave %d function 0x%02X bad response, length %d.", slave, func, len);
+        return(-RT_EIO);
+    }
+    
+    return(RT_EOK);
+}
+
+/* read bits or registers, the datas are received into caller buffer */
+static int rs485_mb_read(rs485_inst_t * hinst, int slave, int func, int addr, int num, void *buf, int size)
+{
+    rt_uint8_t req[8];
+    rt_uint8_t head[3];
+    rt_uint8_t crc[2];
+    rs485_iovec_t rsp[3];
+    int rc;
+    
+    req[0] = slave;
+    req[1] = func;
+    rs485_mb_put16(req + 2, addr);
+    rs485_mb_put16(req + 4, num);
+    
+    rsp[0].base = head;
+    rsp[0].len = sizeof(head);
+    rsp[1].base = buf;
+    rsp[1].len = size;
+    rsp[2].base = crc;
+    rsp[2].len = sizeof(crc);
+    
+    rc = rs485_mb_transact(hinst, req, 6, rsp, 3);
+    if (rc == RT_EOK && head[2] != size)
+    {
+        return(-RT_EIO);
+    }
+    
+    return(rc);
+}
+
+/* send the request and receive the fixed length response into rsp */
+static int rs485_mb_simple(rs485_inst_t * hinst, rt_uint8_t *req, int req_len, rt_uint8_t *rsp, int rsp_len)
+{
+    rs485_iovec_t iov;
+    
+    iov.base = rsp;
+    iov.len = rsp_len;
+    
+    return(rs485_mb_transact(hinst, req, req_len, &iov, 1));
+}
+
+static int rs485_mb_check(rs485_inst_t * hinst, int slave, int broadcast)
+{
+    if (hinst == RT_NULL || slave > 247 || slave < (broadcast ? 0 : 1))
+    {
+        LOG_E("rs485 modbus fail. param is error.");
+        return(-RT_ERROR);
+    }
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   read coils (0x01), the status are packed into bits as the wire order, the first coil in bit0 of bits[0]
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of coils, 1~2000
+ * @param   bits        - output, coils status, (num + 7) / 8 bytes
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_coils(rs485_inst_t * hinst, int slave, int addr, int num, rt_uint8_t *bits)
+{
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK || bits == RT_NULL || num < 1 || num > RS485_MB_READ_BITS_MAX)
+    {
+        return(-RT_ERROR);
+    }
+    return(rs485_mb_read(hinst, slave, RS485_MB_FC_READ_COILS, addr, num, bits, (num + 7) / 8));
+}
+
+/* 
+ * @brief   read discrete inputs (0x02), the status are packed into bits as rs485_mb_read_coils
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of inputs, 1~2000
+ * @param   bits        - output, inputs status, (num + 7) / 8 bytes
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_disc_inputs(rs485_inst_t * hinst, int slave, int addr, int num, rt_uint8_t *bits)
+{
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK || bits == RT_NULL || num < 1 || num > RS485_MB_READ_BITS_MAX)
+    {
+        return(-RT_ERROR);
+    }
+    return(rs485_mb_read(hinst, slave, RS485_MB_FC_READ_DISC_INPUTS, addr, num, bits, (num + 7) / 8));
+}
+
+/* 
+ * @brief   read holding registers (0x03), the registers are received into regs directly
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of registers, 1~125
+ * @param   regs        - output, registers value, the content is undefined when it fails
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_hold_regs(rs485_inst_t * hinst, int slave, int addr, int num, rt_uint16_t *regs)
+{
+    int rc;
+    
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK || regs == RT_NULL || num < 1 || num > RS485_MB_READ_REGS_MAX)
+    {
+        return(-RT_ERROR);
+    }
+    
+    rc = rs485_mb_read(hinst, slave, RS485_MB_FC_READ_HOLD_REGS, addr, num, regs, num * 2);
+    if (rc == RT_EOK)
+    {
+        rs485_mb_regs_in(regs, num);
+    }
+    
+    return(rc);
+}
+
+/* 
+ * @brief   read input registers (0x04), the registers are received into regs directly
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of registers, 1~125
+ * @param   regs        - output, registers value, the content is undefined when it fails
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_input_regs(rs485_inst_t * hinst, int slave, int addr, int num, rt_uint16_t *regs)
+{
+    int rc;
+    
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK || regs == RT_NULL || num < 1 || num > RS485_MB_READ_REGS_MAX)
+    {
+        return(-RT_ERROR);
+    }
+    
+    rc = rs485_mb_read(hinst, slave, RS485_MB_FC_READ_INPUT_REGS, addr, num, regs, num * 2);
+    if (rc == RT_EOK)
+    {
+        rs485_mb_regs_in(regs, num);
+    }
+    
+    return(rc);
+}
+
+/* write single coil or register, the response echoes the request */
+static int rs485_mb_write_single(rs485_inst_t * hinst, int slave, int func, int addr, rt_uint16_t value)
+{
+    rt_uint8_t req[8];
+    rt_uint8_t rsp[8];
+    int rc;
+    
+    req[0] = slave;
+    req[1] = func;
+    rs485_mb_put16(req + 2, addr);
+    rs485_mb_put16(req + 4, value);
+    
+    rc = rs485_mb_simple(hinst, req, 6, rsp, sizeof(rsp));
+    if (rc == RT_EOK && slave != 0 && rt_memcmp(req, rsp, 6) != 0)
+    {
+        return(-RT_EIO);
+    }
+    
+    return(rc);
+}
+
+/* 
+ * @brief   write single coil (0x05)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 0~247
+ * @param   addr        - coil address
+ * @param   on          - 0--off, other--on
+ * @retval  see return of master functions
+ */
+int rs485_mb_write_coil(rs485_inst_t * hinst, int slave, int addr, int on)
+{
+    if (rs485_mb_check(hinst, slave, 1) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    return(rs485_mb_write_single(hinst, slave, RS485_MB_FC_WRITE_COIL, addr, on ? 0xFF00 : 0x0000));
+}
+
+/* 
+ * @brief   write single register (0x06)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 0~247
+ * @param   addr        - register address
+ * @param   value       - register value
+ * @retval  see return of master functions
+ */
+int rs485_mb_write_reg(rs485_inst_t * hinst, int slave, int addr, rt_uint16_t value)
+{
+    if (rs485_mb_check(hinst, slave, 1) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    return(rs485_mb_write_single(hinst, slave, RS485_MB_FC_WRITE_REG, addr, value));
+}
+
+/* 
+ * @brief   read exception status (0x07)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   status      - output, exception status
+ * @retval  see return of master functions
+ */
+int rs485_mb_read_except_status(rs485_inst_t * hinst, int slave, rt_uint8_t *status)
+{
+    rt_uint8_t req[4];
+    rt_uint8_t rsp[5];
+    int rc;
+    
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK || status == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+    
+    req[0] = slave;
+    req[1] = RS485_MB_FC_READ_EXCEPT_STATUS;
+    
+    rc = rs485_mb_simple(hinst, req, 2, rsp, sizeof(rsp));
+    if (rc == RT_EOK)
+    {
+        *status = rsp[2];
+    }
+    
+    return(rc);
+}
+
+/* 
+ * @brief   diagnostics (0x08), for the sub-functions answered with sub-function and a data word
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   sub_func    - sub-function code, 0x0000--return query data
+ * @param   data        - request data
+ * @param   result      - output, response data, can be NULL
+ * @retval  see return of master functions
+ */
+int rs485_mb_diagnostics(rs485_inst_t * hinst, int slave, rt_uint16_t sub_func, rt_uint16_t data, rt_uint16_t *result)
+{
+    rt_uint8_t req[8];
+    rt_uint8_t rsp[8];
+    int rc;
+    
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    
+    req[0] = slave;
+    req[1] = RS485_MB_FC_DIAGNOSTICS;
+    rs485_mb_put16(req + 2, sub_func);
+    rs485_mb_put16(req + 4, data);
+    
+    rc = rs485_mb_simple(hinst, req, 6, rsp, sizeof(rsp));
+    if (rc != RT_EOK)
+    {
+        return(rc);
+    }
+    if (rs485_mb_get16(rsp + 2) != sub_func)
+    {
+        return(-RT_EIO);
+    }
+    if (result)
+    {
+        *result = rs485_mb_get16(rsp + 4);
+    }
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   get comm event counter (0x0B)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   status      - output, status word, can be NULL
+ * @param   count       - output, event count, can be NULL
+ * @retval  see return of master functions
+ */
+int rs485_mb_get_event_counter(rs485_inst_t * hinst, int slave, rt_uint16_t *status, rt_uint16_t *count)
+{
+    rt_uint8_t req[4];
+    rt_uint8_t rsp[8];
+    int rc;
+    
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    
+    req[0] = slave;
+    req[1] = RS485_MB_FC_GET_EVENT_COUNTER;
+    
+    rc = rs485_mb_simple(hinst, req, 2, rsp, sizeof(rsp));
+    if (rc != RT_EOK)
+    {
+        return(rc);
+    }
+    if (status)
+    {
+        *status = rs485_mb_get16(rsp + 2);
+    }
+    if (count)
+    {
+        *count = rs485_mb_get16(rsp + 4);
+    }
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   get comm event log (0x0C), the response length is variable, it completes at frame gap
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   status      - output, status word, can be NULL
+ * @param   event_count - output, event count, can be NULL
+ * @param   msg_count   - output, message count, can be NULL
+ * @param   events      - output, event bytes, the most recent first, RS485_MB_EVENT_LOG_MAX bytes, can be NULL
+ * @param   event_num   - output, count of event bytes, can be NULL
+ * @retval  see return of master functions
+ */
+int rs485_mb_get_event_log(rs485_inst_t * hinst, int slave, rt_uint16_t *status, rt_uint16_t *event_count,
+                            rt_uint16_t *msg_count, rt_uint8_t *events, int *event_num)
+{
+    rt_uint8_t req[4];
+    rt_uint8_t rsp[3 + 6 + RS485_MB_EVENT_LOG_MAX + 2];
+    rs485_iovec_t send_iov, recv_iov;
+    rt_uint16_t crc;
+    rt_uint32_t rx_crc;
+    int len, num;
+    
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK)
+    {
+        return(-RT_ERROR);
+    }
+    
+    req[0] = slave;
+    req[1] = RS485_MB_FC_GET_EVENT_LOG;
+    crc = rs485_mb_crc16(0xFFFF, req, 2);
+    req[2] = (rt_uint8_t)(crc);
+    req[3] = (rt_uint8_t)(crc >> 8);
+    send_iov.base = req;
+    send_iov.len = sizeof(req);
+    recv_iov.base = rsp;
+    recv_iov.len = sizeof(rsp);
+    
+    len = rs485_transferv_crc(hinst, slave, &send_iov, 1, &recv_iov, 1, rs485_mb_count_rsp_done, RT_NULL, 
+                                RS485_CRC_16, &rx_crc);
+    if (len < 0)
+    {
+        return(len);
+    }
+    if (len == 0)
+    {
+        return(-RT_ETIMEOUT);
+    }
+    if (len < RS485_MB_EX_RSP_LEN || rx_crc != RS485_CRC16_RESIDUE || rsp[0] != slave)
+    {
+        return(-RT_EIO);
+    }
+    if (len == RS485_MB_EX_RSP_LEN && rsp[1] == (RS485_MB_FC_GET_EVENT_LOG | 0x80))
+    {
+        return(rsp[2]);
+    }
+    num = rsp[2] - 6;
+    if (rsp[1] != RS485_MB_FC_GET_EVENT_LOG || num < 0 || len != 3 + rsp[2] + 2)
+    {
+        return(-RT_EIO);
+    }
+    
+    if (status)
+    {
+        *status = rs485_mb_get16(rsp + 3);
+    }
+    if (event_count)
+    {
+        *event_count = rs485_mb_get16(rsp + 5);
+    }
+    if (msg_count)
+    {
+        *msg_count = rs485_mb_get16(rsp + 7);
+    }
+    if (events)
+    {
+        rt_memcpy(events, rsp + 9, num);
+    }
+    if (event_num)
+    {
+        *event_num = num;
+    }
+    
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   write multiple coils (0x0F), the status are packed into bits as rs485_mb_read_coils
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 0~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of coils, 1~1968
+ * @param   bits        - coils status, (num + 7) / 8 bytes
+ * @retval  see return of master functions
+ */
+int rs485_mb_write_coils(rs485_inst_t * hinst, int slave, int addr, int num, const rt_uint8_t *bits)
+{
+    rt_uint8_t req[RS485_MB_ADU_MAX];
+    rt_uint8_t rsp[8];
+    int bytes = (num + 7) / 8;
+    int rc;
+    
+    if (rs485_mb_check(hinst, slave, 1) != RT_EOK || bits == RT_NULL || num < 1 || num > RS485_MB_WRITE_BITS_MAX)
+    {
+        return(-RT_ERROR);
+    }
+    
+    req[0] = slave;
+    req[1] = RS485_MB_FC_WRITE_COILS;
+    rs485_mb_put16(req + 2, addr);
+    rs485_mb_put16(req + 4, num);
+    req[6] = bytes;
+    rt_memcpy(req + 7, bits, bytes);
+    
+    rc = rs485_mb_simple(hinst, req, 7 + bytes, rsp, sizeof(rsp));
+    if (rc == RT_EOK && slave != 0 && rt_memcmp(req + 2, rsp + 2, 4) != 0)
+    {
+        return(-RT_EIO);
+    }
+    
+    return(rc);
+}
+
+/* 
+ * @brief   write multiple registers (0x10)
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 0~247
+ * @param   addr        - starting address
+ * @param   num         - quantity of registers, 1~123
+ * @param   regs        - registers value
+ * @retval  see return of master functions
+ */
+int rs485_mb_write_regs(rs485_inst_t * hinst, int slave, int addr, int num, const rt_uint16_t *regs)
+{
+    rt_uint8_t req[RS485_MB_ADU_MAX];
+    rt_uint8_t rsp[8];
+    int len = 7;
+    int rc;
+    
+    if (rs485_mb_check(hinst, slave, 1) != RT_EOK || regs == RT_NULL || num < 1 || num > RS485_MB_WRITE_REGS_MAX)
+    {
+        return(-RT_ERROR);
+    }
+    
+    req[0] = slave;
+    req[1] = RS485_MB_FC_WRITE_REGS;
+    rs485_mb_put16(req + 2, addr);
+    rs485_mb_put16(req + 4, num);
+    req[6] = num * 2;
+    for (int i = 0; i < num; i++)
+    {
+        len += rs485_mb_put16(req + len, regs[i]);
+    }
+    
+    rc = rs485_mb_simple(hinst, req, len, rsp, sizeof(rsp));
+    if (rc == RT_EOK && slave != 0 && rt_memcmp(req + 2, rsp + 2, 4) != 0)
+    {
+        return(-RT_EIO);
+    }
+    
+    return(rc);
+}
+
+/* 
+ * @brief   read/write multiple registers (0x17), the write is done before the read by slave
+ * @param   hinst       - instance handle
+ * @param   slave       - slave address, 1~247
+ * @param   rd_addr     - read starting address
+ * @param   rd_num      - quantity to read, 1~125
+ * @param   rd_regs     - output, registers read, the content is undefined when it fails
+ * @param   wr_addr     - write starting address
+ * @param   wr_num      - quantity to write, 1~121
+ * @param   wr_regs     - registers value to write
+ * @retval  see return of master functions
+ */
+int rs485_mb_rw_regs(rs485_inst_t * hinst, int slave, int rd_addr, int rd_num, rt_uint16_t *rd_regs,
+                        int wr_addr, int wr_num, const rt_uint16_t *wr_regs)
+{
+    rt_uint8_t req[RS485_MB_ADU_MAX];
+    rt_uint8_t head[3];
+    rt_uint8_t crc[2];
+    rs485_iovec_t rsp[3];
+    int len = 11;
+    int rc;
+    
+    if (rs485_mb_check(hinst, slave, 0) != RT_EOK || rd_regs == RT_NULL || wr_regs == RT_NULL || 
+        rd_num < 1 || rd_num > RS485_MB_READ_REGS_MAX || wr_num < 1 || wr_num > RS485_MB_RW_WRITE_REGS_MAX)
+    {
+        return(-RT_ERROR);
+    }
+    
+    req[0] = slave;
+    req[1] = RS485_MB_FC_RW_REGS;
+    rs485_mb_put16(req + 2, rd_addr);
+    rs485_mb_put16(req + 4, rd_num);
+    rs485_mb_put16(req + 6, wr_addr);
+    rs485_mb_put16(req + 8, wr_num);
+    req[10] = wr_num * 2;
+    for (int i = 0; i < wr_num; i++)
+    {
+        len += rs485_mb_put16(req + len, wr_regs[i]);
+    }
+    
+    rsp[0].base = head;
+    rsp[0].len = sizeof(head);
+    rsp[1].base = rd_regs;
+    rsp[1].len = rd_num * 2;
+    rsp[2].base = crc;
+    rsp[2].len = sizeof(crc);
+    
+    rc = rs485_mb_transact(hinst, req, len, rsp, 3);
+    if (rc != RT_EOK)
+    {
+        return(rc);
+    }
+    if (head[2] != rd_num * 2)
+    {
+        return(-RT_EIO);
+    }
+    rs485_mb_regs_in(rd_regs, rd_num);
+    
+    return(RT_EOK);
+}
+
+#endif
+
@@ -0,0 +1,543 @@
+/*
+ * rs485_modbus_slave.c
+ *
+ * modbus rtu slave on rs485 instance, requests are served by the frame handler worker
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       fix access past the last map
+ */
+
+#include <rtthread.h>
+#include <rs485.h>
+#include <rs485_modbus.h>
+#include <rs485_crc.h>
+
+#define DBG_TAG "rs485.modbus.slave"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#ifdef RS485_USING_MODBUS_SLAVE
+
+#define RS485_MB_BITS_BYTES     ((RS485_MB_READ_BITS_MAX + 7) / 8)
+
+static rt_uint16_t rs485_mb_slave_get16(const rt_uint8_t *p)
+{
+    return((rt_uint16_t)((p[0] << 8) | p[1]));
+}
+
+static void rs485_mb_slave_put16(rt_uint8_t *p, rt_uint16_t v)
+{
+    p[0] = (rt_uint8_t)(v >> 8);
+    p[1] = (rt_uint8_t)(v);
+}
+
+static int rs485_mb_slave_get_bit(const rt_uint8_t *bits, int pos)
+{
+    return((bits[pos >> 3] >> (pos & 7)) & 0x01);
+}
+
+static void rs485_mb_slave_set_bit(rt_uint8_t *bits, int pos, int val)
+{
+    if (val)
+    {
+        bits[pos >> 3] |= (1 << (pos & 7));
+    }
+    else
+    {
+        bits[pos >> 3] &= ~(1 << (pos & 7));
+    }
+}
+
+/* binary search the map holding addr, returns index of map or -1 */
+static int rs485_mb_slave_find(const rs485_mb_map_t *maps, int num, int addr)
+{
+    int lo = 0;
+    int hi = num - 1;
+
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) >> 1;
+        if (addr < maps[mid].start)
+        {
+            hi = mid - 1;
+        }
+        else if (addr >= maps[mid].start + maps[mid].num)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            return(mid);
+        }
+    }
+
+    return(-1);
+}
+
+/* read or write registers or bits of a table, the range can span adjacent maps,
+   buf is rt_uint16_t array of registers or packed bits, returns 0 or exception code */
+static int rs485_mb_slave_access(rs485_mb_slave_t * slave, int table, int addr, int num, void *buf, int write)
+{
+    const rs485_mb_map_t *maps = slave->maps[table];
+    int bits = (table == RS485_MB_COILS || table == RS485_MB_DISC_INPUTS);
+    int idx = rs485_mb_slave_find(maps, slave->map_num[table], addr);
+    int done = 0;
+
+    if (idx < 0 || addr + num > 0x10000)
+    {
+        return(RS485_MB_EX_ILLEGAL_ADDRESS);
+    }
+
+    while (done < num)
+    {
+        const rs485_mb_map_t *m;
+        int a = addr + done;
+        int off, n;
+        int rc = 0;
+
+        if (idx >= slave->map_num[table])//past the last map
+        {
+            return(RS485_MB_EX_ILLEGAL_ADDRESS);
+        }
+        m = &maps[idx];
+        off = a - m->start;
+        n = m->start + m->num - a;
+        if (off < 0)//hole between maps
+        {
+            return(RS485_MB_EX_ILLEGAL_ADDRESS);
+        }
+        if (n > num - done)
+        {
+            n = num - done;
+        }
+
+        if (m->mem && (write == 0 || m->write == RT_NULL))//memory binding
+        {
+            if (bits)
+            {
+                for (int i = 0; i < n; i++)
+                {
+                    if (write)
+                    {
+                        rs485_mb_slave_set_bit(m->mem, off + i, rs485_mb_slave_get_bit(buf, done + i));
+                    }
+                    else
+                    {
+                        rs485_mb_slave_set_bit(buf, done + i, rs485_mb_slave_get_bit(m->mem, off + i));
+                    }
+                }
+            }
+            else if (write)
+            {
+                rt_memcpy((rt_uint16_t *)m->mem + off, (rt_uint16_t *)buf + done, n * 2);
+            }
+            else
+            {
+                rt_memcpy((rt_uint16_t *)buf + done, (rt_uint16_t *)m->mem + off, n * 2);
+            }
+        }
+        else//callbacks
+        {
+            rs485_mb_access_t cb = write ? m->write : m->read;
+            if (cb == RT_NULL)
+            {
+                return(RS485_MB_EX_ILLEGAL_ADDRESS);
+            }
+            if (bits)
+            {
+                rt_uint8_t tmp[RS485_MB_BITS_BYTES];
+                if (write)
+                {
+                    for (int i = 0; i < n; i++)
+                    {
+                        rs485_mb_slave_set_bit(tmp, i, rs485_mb_slave_get_bit(buf, done + i));
+                    }
+                    rc = cb(m->ctx, a, n, tmp);
+                }
+                else
+                {
+                    rt_memset(tmp, 0, (n + 7) / 8);
+                    rc = cb(m->ctx, a, n, tmp);
+                    for (int i = 0; i < n; i++)
+                    {
+                        rs485_mb_slave_set_bit(buf, done + i, rs485_mb_slave_get_bit(tmp, i));
+                    }
+                }
+            }
+            else
+            {
+                rc = cb(m->ctx, a, n, (rt_uint16_t *)buf + done);
+            }
+            if (rc)
+            {
+                return(rc);
+            }
+        }
+
+        done += n;
+        idx++;
+    }
+
+    return(0);
+}
+
+/* build exception response */
+static int rs485_mb_slave_except(rs485_mb_slave_t * slave, int func, int code)
+{
+    slave->rsp[1] = func | 0x80;
+    slave->rsp[2] = code;
+    return(3);
+}
+
+/* read bits, response is packed in place */
+static int rs485_mb_slave_read_bits(rs485_mb_slave_t * slave, int table, const rt_uint8_t *req, int len)
+{
+    int addr = rs485_mb_slave_get16(req + 2);
+    int num = rs485_mb_slave_get16(req + 4);
+    int bytes = (num + 7) / 8;
+    int rc;
+
+    if (len != 6 || num < 1 || num > RS485_MB_READ_BITS_MAX)
+    {
+        return(rs485_mb_slave_except(slave, req[1], RS485_MB_EX_ILLEGAL_VALUE));
+    }
+
+    rt_memset(slave->rsp + 3, 0, bytes);
+    rc = rs485_mb_slave_access(slave, table, addr, num, slave->rsp + 3, 0);
+    if (rc)
+    {
+        return(rs485_mb_slave_except(slave, req[1], rc));
+    }
+    slave->rsp[2] = bytes;
+
+    return(3 + bytes);
+}
+
+/* read registers, converted to wire order into response */
+static int rs485_mb_slave_read_regs(rs485_mb_slave_t * slave, int table, const rt_uint8_t *req, int len)
+{
+    int addr = rs485_mb_slave_get16(req + 2);
+    int num = rs485_mb_slave_get16(req + 4);
+    int rc;
+
+    if (len != 6 || num < 1 || num > RS485_MB_READ_REGS_MAX)
+    {
+        return(rs485_mb_slave_except(slave, req[1], RS485_MB_EX_ILLEGAL_VALUE));
+    }
+
+    rc = rs485_mb_slave_access(slave, table, addr, num, slave->regs, 0);
+    if (rc)
+    {
+        return(rs485_mb_slave_except(slave, req[1], rc));
+    }
+    slave->rsp[2] = num * 2;
+    for (int i = 0; i < num; i++)
+    {
+        rs485_mb_slave_put16(slave->rsp + 3 + i * 2, slave->regs[i]);
+    }
+
+    return(3 + num * 2);
+}
+
+/* write single coil or register, response echoes the request */
+static int rs485_mb_slave_write_single(rs485_mb_slave_t * slave, const rt_uint8_t *req, int len)
+{
+    int addr = rs485_mb_slave_get16(req + 2);
+    rt_uint16_t value = rs485_mb_slave_get16(req + 4);
+    int rc;
+
+    if (len != 6)
+    {
+        return(rs485_mb_slave_except(slave, req[1], RS485_MB_EX_ILLEGAL_VALUE));
+    }
+
+    if (req[1] == RS485_MB_FC_WRITE_COIL)
+    {
+        rt_uint8_t bit = (value == 0xFF00);
+        if (value != 0xFF00 && value != 0x0000)
+        {
+            return(rs485_mb_slave_except(slave, req[1], RS485_MB_EX_ILLEGAL_VALUE));
+        }
+        rc = rs485_mb_slave_access(slave, RS485_MB_COILS, addr, 1, &bit, 1);
+    }
+    else
+    {
+        slave->regs[0] = value;
+        rc = rs485_mb_slave_access(slave, RS485_MB_HOLD_REGS, addr, 1, slave->regs, 1);
+    }
+    if (rc)
+    {
+        return(rs485_mb_slave_except(slave, req[1], rc));
+    }
+    rt_memcpy(slave->rsp + 2, req + 2, 4);
+
+    return(6);
+}
+
+/* write multiple coils */
+static int rs485_mb_slave_write_coils(rs485_mb_slave_t * slave, const rt_uint8_t *req, int len)
+{
+    int addr = rs485_mb_slave_get16(req + 2);
+    int num = rs485_mb_slave_get16(req + 4);
+    int rc;
+
+    if (len < 7 || num < 1 || num > RS485_MB_WRITE_BITS_MAX || req[6] != (num + 7) / 8 || len != 7 + req[6])
+    {
+        return(rs485_mb_slave_except(slave, req[1], RS485_MB_EX_ILLEGAL_VALUE));
+    }
+
+    rc = rs485_mb_slave_access(slave, RS485_MB_COILS, addr, num, (void *)(req + 7), 1);
+    if (rc)
+    {
+        return(rs485_mb_slave_except(slave, req[1], rc));
+    }
+    rt_memcpy(slave->rsp + 2, req + 2, 4);
+
+    return(6);
+}
+
+/* write multiple registers */
+static int rs485_mb_slave_write_regs(rs485_mb_slave_t * slave, const rt_uint8_t *req, int len)
+{
+    int addr = rs485_mb_slave_get16(req + 2);
+    int num = rs485_mb_slave_get16(req + 4);
+    int rc;
+
+    if (len < 7 || num < 1 || num > RS485_MB_WRITE_REGS_MAX || req[6] != num * 2 || len != 7 + req[6])
+    {
+        return(rs485_mb_slave_except(slave, req[1], RS485_MB_EX_ILLEGAL_VALUE));
+    }
+
+    for (int i = 0; i < num; i++)
+    {
+        slave->regs[i] = rs485_mb_slave_get16(req + 7 + i * 2);
+    }
+    rc = rs485_mb_slave_access(slave, RS485_MB_HOLD_REGS, addr, num, slave->regs, 1);
+    if (rc)
+    {
+        return(rs485_mb_slave_except(slave, req[1], rc));
+    }
+    rt_memcpy(slave->rsp + 2, req + 2, 4);
+
+    return(6);
+}
+
+/* read/write multiple registers, the write is done before the read */
+static int rs485_mb_slave_rw_regs(rs485_mb_slave_t * slave, const rt_uint8_t *req, int len)
+{
+    int wr_addr, wr_num;
+    int rc;
+
+    if (len < 11)
+    {
+        return(rs485_mb_slave_except(slave, req[1], RS485_MB_EX_ILLEGAL_VALUE));
+    }
+    wr_addr = rs485_mb_slave_get16(req + 6);
+    wr_num = rs485_mb_slave_get16(req + 8);
+    if (wr_num < 1 || wr_num > RS485_MB_RW_WRITE_REGS_MAX || req[10] != wr_num * 2 || len != 11 + req[10])
+    {
+        return(rs485_mb_slave_except(slave, req[1], RS485_MB_EX_ILLEGAL_VALUE));
+    }
+
+    for (int i = 0; i < wr_num; i++)
+    {
+        slave->regs[i] = rs485_mb_slave_get16(req + 11 + i * 2);
+    }
+    rc = rs485_mb_slave_access(slave, RS485_MB_HOLD_REGS, wr_addr, wr_num, slave->regs, 1);
+    if (rc)
+    {
+        return(rs485_mb_slave_except(slave, req[1], rc));
+    }
+
+    return(rs485_mb_slave_read_regs(slave, RS485_MB_HOLD_REGS, req, 6));
+}
+
+/* 
+ * @brief   process a request frame and send the response, it is the frame handler of slave,
+ *          the crc is taken from the running receive crc, so the frame should be the last one received by hinst
+ * @param   hinst       - rs485 instance
+ * @param   buf         - request frame
+ * @param   len         - length of request frame
+ * @param   ctx         - slave instance
+ * @retval  none
+ */
+void rs485_mb_slave_handler(rs485_inst_t * hinst, const rt_uint8_t *buf, int len, void *ctx)
+{
+    rs485_mb_slave_t *slave = (rs485_mb_slave_t *)ctx;
+    int broadcast;
+    int rsp_len;
+    rt_uint16_t crc;
+
+    if (len < 4 || (buf[0] != slave->addr && buf[0] != 0))//not for this slave
+    {
+        return;
+    }
+    if (rs485_get_rx_crc(hinst) != RS485_CRC16_RESIDUE)//checked by worker while the frame arriving
+    {
+        slave->err_count++;
+        return;
+    }
+
+    broadcast = (buf[0] == 0);
+    slave->msg_count++;
+    len -= 2;
+    slave->rsp[0] = slave->addr;
+    slave->rsp[1] = buf[1];
+
+    switch (buf[1])
+    {
+    case RS485_MB_FC_READ_COILS:
+        rsp_len = rs485_mb_slave_read_bits(slave, RS485_MB_COILS, buf, len);
+        break;
+    case RS485_MB_FC_READ_DISC_INPUTS:
+        rsp_len = rs485_mb_slave_read_bits(slave, RS485_MB_DISC_INPUTS, buf, len);
+        break;
+    case RS485_MB_FC_READ_HOLD_REGS:
+        rsp_len = rs485_mb_slave_read_regs(slave, RS485_MB_HOLD_REGS, buf, len);
+        break;
+    case RS485_MB_FC_READ_INPUT_REGS:
+        rsp_len = rs485_mb_slave_read_regs(slave, RS485_MB_INPUT_REGS, buf, len);
+        break;
+    case RS485_MB_FC_WRITE_COIL:
+    case RS485_MB_FC_WRITE_REG:
+        rsp_len = rs485_mb_slave_write_single(slave, buf, len);
+        break;
+    case RS485_MB_FC_WRITE_COILS:
+        rsp_len = rs485_mb_slave_write_coils(slave, buf, len);
+        break;
+    case RS485_MB_FC_WRITE_REGS:
+        rsp_len = rs485_mb_slave_write_regs(slave, buf, len);
+        break;
+    case RS485_MB_FC_RW_REGS:
+        rsp_len = rs485_mb_slave_rw_regs(slave, buf, len);
+        break;
+    case RS485_MB_FC_DIAGNOSTICS://return query data only
+        if (len < 4 || rs485_mb_slave_get16(buf + 2) != 0x0000)
+        {
+            rsp_len = rs485_mb_slave_except(slave, buf[1], RS485_MB_EX_ILLEGAL_FUNCTION);
+            break;
+        }
+        rt_memcpy(slave->rsp + 2, buf + 2, len - 2);
+        rsp_len = len;
+        break;
+    case RS485_MB_FC_GET_EVENT_COUNTER:
+        rs485_mb_slave_put16(slave->rsp + 2, 0x0000);
+        rs485_mb_slave_put16(slave->rsp + 4, slave->event_count);
+        rsp_len = 6;
+        break;
+    default:
+        rsp_len = rs485_mb_slave_except(slave, buf[1], RS485_MB_EX_ILLEGAL_FUNCTION);
+        break;
+    }
+
+    if ((slave->rsp[1] & 0x80) == 0 && buf[1] != RS485_MB_FC_GET_EVENT_COUNTER)
+    {
+        slave->event_count++;
+    }
+
+    if (broadcast)//no response to broadcast
+    {
+        return;
+    }
+
+    crc = rs485_mb_crc16(0xFFFF, slave->rsp, rsp_len);
+    slave->rsp[rsp_len++] = (rt_uint8_t)(crc);
+    slave->rsp[rsp_len++] = (rt_uint8_t)(crc >> 8);
+    rs485_send(hinst, slave->rsp, rsp_len);
+}
+
+/* 
+ * @brief   initialize modbus slave
+ * @param   slave       - slave instance
+ * @param   hinst       - rs485 instance, connected by user
+ * @param   addr        - slave address, 1~247
+ * @retval  0 - success, other - error
+ */
+int rs485_mb_slave_init(rs485_mb_slave_t * slave, rs485_inst_t * hinst, int addr)
+{
+    if (slave == RT_NULL || hinst == RT_NULL || addr < 1 || addr > 247)
+    {
+        LOG_E("rs485 modbus slave init fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    rt_memset(slave, 0, sizeof(rs485_mb_slave_t));
+    slave->hinst = hinst;
+    slave->addr = addr;
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   set register maps of a table, the maps are used in place and should be kept
+ * @param   slave       - slave instance
+ * @param   table       - table, RS485_MB_COILS, RS485_MB_DISC_INPUTS, RS485_MB_HOLD_REGS, RS485_MB_INPUT_REGS
+ * @param   maps        - maps array, sorted by start address and not overlapped
+ * @param   num         - count of maps
+ * @retval  0 - success, other - error
+ */
+int rs485_mb_slave_set_map(rs485_mb_slave_t * slave, int table, const rs485_mb_map_t *maps, int num)
+{
+    if (slave == RT_NULL || table < 0 || table >= RS485_MB_TABLES || (num > 0 && maps == RT_NULL) || num < 0)
+    {
+        LOG_E("rs485 modbus slave set map fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    for (int i = 0; i < num; i++)
+    {
+        if (maps[i].num == 0 || (maps[i].mem == RT_NULL && maps[i].read == RT_NULL))
+        {
+            LOG_E("rs485 modbus slave set map fail. map %d is empty.", i);
+            return(-RT_ERROR);
+        }
+        if (i > 0 && maps[i].start < maps[i - 1].start + maps[i - 1].num)
+        {
+            LOG_E("rs485 modbus slave set map fail. map %d is not sorted or overlapped.", i);
+            return(-RT_ERROR);
+        }
+    }
+
+    slave->maps[table] = maps;
+    slave->map_num[table] = num;
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   start modbus slave, requests are served by the frame handler worker thread
+ * @param   slave       - slave instance
+ * @retval  0 - success, other - error
+ */
+int rs485_mb_slave_start(rs485_mb_slave_t * slave)
+{
+    if (slave == RT_NULL || slave->hinst == RT_NULL)
+    {
+        LOG_E("rs485 modbus slave start fail. it is not initialized.");
+        return(-RT_ERROR);
+    }
+
+    rs485_set_rx_crc(slave->hinst, RS485_CRC_16);
+    
+    return(rs485_set_frame_handler(slave->hinst, rs485_mb_slave_handler, slave));
+}
+
+/* 
+ * @brief   stop modbus slave
+ * @param   slave       - slave instance
+ * @retval  0 - success, other - error
+ */
+int rs485_mb_slave_stop(rs485_mb_slave_t * slave)
+{
+    if (slave == RT_NULL || slave->hinst == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+
+    return(rs485_set_frame_handler(slave->hinst, RT_NULL, RT_NULL));
+}
+
+#endif
+
@@ -5,6 +5,7 @@
  * Date           Author            Notes
  * 2020-12-17     qiyongzhong       first version
  * 2020-12-18     qiyongzhong       fix to rs485_send_then_recv
+ * 2026-10-17     qiyongzhong       receive response lines by rs485_send_then_recv_until
  */
     
 #include <rtthread.h>
@@ -62,7 +63,7 @@ static void rs485_sample_master(void *args)
     while(1)
     {
         int len = strlen(read_cmd);
-        len = rs485_send_then_recv(hinst, (void *)read_cmd, len, buf, sizeof(buf));
+        len = rs485_send_then_recv_until(hinst, read_cmd, len, buf, sizeof(buf) - 1, "\r\n", 2);
         if (len < 0)
         {
             LOG_E("rs485 send datas error.");
@@ -4,6 +4,8 @@
  * Change Logs:
  * Date           Author            Notes
  * 2020-12-17     qiyongzhong       first version
+ * 2026-10-17     qiyongzhong       use frame handler when enabled
+ * 2026-10-17     qiyongzhong       use static instance
  */
     
 #include <rtthread.h>
@@ -36,23 +38,62 @@
 #define RS485_SAMPLE_SLAVE_LVL          1
 #endif
 
-static void rs485_sample_slave_loopback_test(void *args)
+static rs485_inst_t rs485_sample_slave_inst;
+
+static rs485_inst_t * rs485_sample_slave_open(void)
 {
-    static rt_uint8_t buf[256];
-    rs485_inst_t *hinst = rs485_create(RS485_SAMPLE_SLAVE_SERIAL, RS485_SAMPLE_SLAVE_BAUDRATE, 
-                                        RS485_SAMPLE_MASTER_PARITY, RS485_SAMPLE_SLAVE_PIN, RS485_SAMPLE_SLAVE_LVL);
+    rs485_inst_t *hinst = &rs485_sample_slave_inst;
 
-    if (hinst == RT_NULL)
+    if (rs485_init(hinst, RS485_SAMPLE_SLAVE_SERIAL, RS485_SAMPLE_SLAVE_BAUDRATE, 
+                    RS485_SAMPLE_MASTER_PARITY, RS485_SAMPLE_SLAVE_PIN, RS485_SAMPLE_SLAVE_LVL) != RT_EOK)
     {
-        LOG_E("create rs485 instance fail.");
-        return;
+        LOG_E("init rs485 instance fail.");
+        return(RT_NULL);
     }
 
     rs485_set_recv_tmo(hinst, RT_WAITING_FOREVER);
     if (rs485_connect(hinst) != RT_EOK)
     {
-        rs485_destory(hinst);
+        rs485_detach(hinst);
         LOG_E("rs485 connect fail.");
+        return(RT_NULL);
+    }
+    
+    return(hinst);
+}
+
+#ifdef RS485_USING_FRAME_HANDLER
+static void rs485_sample_slave_loopback_handler(rs485_inst_t * hinst, const rt_uint8_t *buf, int len, void *ctx)
+{
+    rs485_send(hinst, (void *)buf, len);
+}
+
+static int rs485_sample_slave_init(void)
+{
+    rs485_inst_t *hinst = rs485_sample_slave_open();
+    
+    if (hinst == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+    
+    if (rs485_set_frame_handler(hinst, rs485_sample_slave_loopback_handler, RT_NULL) != RT_EOK)
+    {
+        rs485_detach(hinst);
+        LOG_E("rs485 set frame handler fail.");
+        return(-RT_ERROR);
+    }
+    LOG_I("rs485 sample slave frame handler startup...");
+    return(RT_EOK);
+}
+#else
+static void rs485_sample_slave_loopback_test(void *args)
+{
+    static rt_uint8_t buf[256];
+    rs485_inst_t *hinst = rs485_sample_slave_open();
+
+    if (hinst == RT_NULL)
+    {
         return;
     }
 
@@ -74,6 +115,7 @@ static int rs485_sample_slave_init(void)
     LOG_I("rs485 sample slave thread startup...");
     return(RT_EOK);
 }
+#endif
 INIT_APP_EXPORT(rs485_sample_slave_init);
 
 #endif
@@ -0,0 +1,201 @@
+/*
+ * rs485_sched.c
+ *
+ * deadline based master poll scheduler on rs485 instance
+ *
+ * Change Logs:
+ * Date           Author            Notes
+ * 2026-10-17     qiyongzhong       first version
+ */
+
+#include <rtthread.h>
+#include <rs485.h>
+#include <rs485_sched.h>
+
+#define DBG_TAG "rs485.sched"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#ifdef RS485_USING_SCHED
+
+/* 
+ * @brief   initialize poll scheduler
+ * @param   sched       - scheduler
+ * @param   hinst       - instance polled, connected by user
+ * @param   backoff_max - longest poll interval of a slave keeps timing out, ms, 0--RS485_SCHED_BACKOFF_MAX
+ * @retval  0 - success, other - error
+ */
+int rs485_sched_init(rs485_sched_t * sched, rs485_inst_t * hinst, int backoff_max)
+{
+    if (sched == RT_NULL || hinst == RT_NULL || backoff_max < 0)
+    {
+        LOG_E("rs485 sched init fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    sched->hinst = hinst;
+    sched->items = RT_NULL;
+    sched->backoff_max = rt_tick_from_millisecond(backoff_max ? backoff_max : RS485_SCHED_BACKOFF_MAX);
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   add poll item to scheduler, it is due at once
+ * @param   sched       - scheduler
+ * @param   item        - poll item
+ * @param   poll        - poll function
+ * @param   ctx         - context passed to poll function
+ * @param   period      - poll period, ms
+ * @param   prio        - priority between items due at the same tick, smaller is higher
+ * @retval  0 - success, other - error
+ */
+int rs485_sched_add(rs485_sched_t * sched, rs485_poll_item_t * item, rs485_poll_t poll, void *ctx, int period, int prio)
+{
+    if (sched == RT_NULL || item == RT_NULL || poll == RT_NULL || period <= 0 || prio < 0 || prio > 255)
+    {
+        LOG_E("rs485 sched add fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    rt_memset(item, 0, sizeof(rs485_poll_item_t));
+    item->poll = poll;
+    item->ctx = ctx;
+    item->period = rt_tick_from_millisecond(period);
+    if (item->period == 0)
+    {
+        item->period = 1;
+    }
+    item->prio = prio;
+    item->deadline = rt_tick_get();
+    item->next = sched->items;
+    sched->items = item;
+
+    return(RT_EOK);
+}
+
+/* 
+ * @brief   remove poll item from scheduler
+ * @param   sched       - scheduler
+ * @param   item        - poll item
+ * @retval  0 - success, other - error
+ */
+int rs485_sched_remove(rs485_sched_t * sched, rs485_poll_item_t * item)
+{
+    if (sched == RT_NULL || item == RT_NULL)
+    {
+        LOG_E("rs485 sched remove fail. param is error.");
+        return(-RT_ERROR);
+    }
+
+    for (rs485_poll_item_t **pp = &sched->items; *pp != RT_NULL; pp = &(*pp)->next)
+    {
+        if (*pp == item)
+        {
+            *pp = item->next;
+            item->next = RT_NULL;
+            return(RT_EOK);
+        }
+    }
+
+    return(-RT_ERROR);
+}
+
+/* the next poll interval, doubled by each consecutive timeout up to backoff max */
+static rt_tick_t rs485_sched_interval(rs485_sched_t * sched, rs485_poll_item_t * item)
+{
+    rt_tick_t interval = item->period;
+
+    for (int i = 0; i < item->fails; i++)
+    {
+        interval <<= 1;
+        if (interval >= sched->backoff_max)
+        {
+            interval = (sched->backoff_max > item->period) ? sched->backoff_max : item->period;
+            break;
+        }
+    }
+
+    return(interval);
+}
+
+/* 
+ * @brief   run the poll of the earliest deadline if it is due
+ * @param   sched       - scheduler
+ * @retval  ticks until the next poll is due, 0--a poll ran or is due, RT_WAITING_FOREVER--no item or error
+ */
+int rs485_sched_poll(rs485_sched_t * sched)
+{
+    rs485_poll_item_t *best = RT_NULL;
+    rt_tick_t now = rt_tick_get();
+    rt_int32_t left = 0;
+    rt_uint32_t late;
+    int rc;
+
+    if (sched == RT_NULL)
+    {
+        LOG_E("rs485 sched poll fail. sched is NULL.");
+        return(RT_WAITING_FOREVER);
+    }
+
+    for (rs485_poll_item_t *item = sched->items; item != RT_NULL; item = item->next)
+    {
+        rt_int32_t d = (rt_int32_t)(item->deadline - now);
+        if (best == RT_NULL || d < left || (d == left && item->prio < best->prio))
+        {
+            best = item;
+            left = d;
+        }
+    }
+
+    if (best == RT_NULL)
+    {
+        return(RT_WAITING_FOREVER);
+    }
+
+    if (left > 0)
+    {
+        return(left);
+    }
+
+    late = (rt_uint32_t)(-left);
+    best->stats.polls++;
+    best->stats.late_sum += late;
+    if (late > best->stats.late_max)
+    {
+        best->stats.late_max = late;
+    }
+
+    rc = best->poll(sched->hinst, best->ctx);
+    if (rc == -RT_ETIMEOUT)//dead slave, back off from the end of the poll, it used the whole timeout
+    {
+        best->stats.timeouts++;
+        if (best->fails < RS485_SCHED_BACKOFF_SHIFT)
+        {
+            best->fails++;
+        }
+        best->deadline = rt_tick_get() + rs485_sched_interval(sched, best);
+        return(0);
+    }
+
+    if (rc < 0)
+    {
+        best->stats.errors++;
+    }
+    if (best->fails)//alive again, back to its period
+    {
+        LOG_D("rs485 sched item %p answered after %d timeouts.", best, best->fails);
+        best->fails = 0;
+    }
+
+    best->deadline += best->period;
+    now = rt_tick_get();
+    if ((rt_int32_t)(best->deadline - now) < 0)//missed polls are dropped, not caught up
+    {
+        best->deadline = now;
+    }
+
+    return(0);
+}
+
+#endif
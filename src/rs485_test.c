@@ -6,10 +6,35 @@
  * 2020-06-08     qiyongzhong       first version
  * 2020-12-17     qiyongzhong       add config function
  * 2020-12-18     qiyongzhong       add send_then_recv
+ * 2026-10-17     qiyongzhong       add set_byte_tmo_us
+ * 2026-10-17     qiyongzhong       add connect flags
+ * 2026-10-17     qiyongzhong       add recv_frame
+ * 2026-10-17     qiyongzhong       add set_sw_dly
+ * 2026-10-17     qiyongzhong       add send_async
+ * 2026-10-17     qiyongzhong       add sendv
+ * 2026-10-17     qiyongzhong       add batch
+ * 2026-10-17     qiyongzhong       add modbus commands
+ * 2026-10-17     qiyongzhong       add mb_slave
+ * 2026-10-17     qiyongzhong       add set_rx_crc
+ * 2026-10-17     qiyongzhong       add recv_line
+ * 2026-10-17     qiyongzhong       add stats
+ * 2026-10-17     qiyongzhong       add trace
+ * 2026-10-17     qiyongzhong       add loop
+ * 2026-10-17     qiyongzhong       add sched
+ * 2026-10-17     qiyongzhong       add rto
+ * 2026-10-17     qiyongzhong       show receive ring drops in stats
+ * 2026-10-17     qiyongzhong       add send_then_recv_dl
+ * 2026-10-17     qiyongzhong       add hardware direction connect flag
+ * 2026-10-17     qiyongzhong       limit sizes of rto to test buffer
+ * 2026-10-17     qiyongzhong       limit sizes of send_then_recv_dl to test buffer
+ * 2026-10-17     qiyongzhong       add idle line frame end connect flag
  */
 
 #include <rtthread.h>
 #include <rs485.h>
+#include <rs485_modbus.h>
+#include <rs485_crc.h>
+#include <rs485_sched.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -45,6 +70,7 @@
 
 static rs485_inst_t * test_hinst = RT_NULL;
 static char test_buf[RS485_TEST_BUF_SIZE];
+static int test_crc_type = RS485_CRC_NONE;
 
 static const char *cmd_info[] =
 {
@@ -53,15 +79,86 @@ static const char *cmd_info[] =
     "rs485 destory                                           - destory rs485 instance.\n",
     "rs485 set_recv_tmo [tmo_ms]                             - set recieve timeout.\n",
     "rs485 set_byte_tmo [tmo_ms]                             - set byte timeout.\n",
-    "rs485 connect                                           - open rs485 connect.\n",
+    "rs485 set_byte_tmo_us [tmo_us]                          - set byte timeout in microseconds.\n",
+    "rs485 set_sw_dly [pre_us] [post_us]                     - set direction switch delays, -1--default.\n",
+    "rs485 set_rx_crc [type]                                 - set crc checked on receive, 0--none, 1--crc16, 2--crc32.\n",
+    "rs485 connect [flags]                                   - open rs485 connect, flags : 1--dma receive, 2--dma transmit, 4--hardware direction, 8--idle line frame end.\n",
     "rs485 disconn                                           - close rs485 connect.\n",
     "rs485 recv [size]                                       - receive from rs485.\n",
     "rs485 send [size]                                       - send to rs485.\n",
+    "rs485 recv_line [size]                                  - receive a line ended with \\r\\n from rs485.\n",
+    "rs485 sendv [size] [segs]                               - send to rs485 gathered from segments.\n",
+    "rs485 send_async [size]                                 - send to rs485 asynchronously and wait completion.\n",
+#ifdef RS485_USING_FRAME_POOL
+    "rs485 recv_frame                                        - receive a frame into frame pool.\n",
+#endif
     "rs485 cfg [baudrate] [databits] [parity] [stopbits]     - config rs485.\n",
     "rs485 send_then_recv [send_size] [recv_size]            - send to rs485 and then receive from rs485.\n",
+    "rs485 send_then_recv_dl [send_size] [recv_size] [ms]    - send then receive, the whole transaction ends by deadline.\n",
+    "rs485 batch [count] [send_size] [recv_size]             - run send_then_recv transactions in one batch.\n",
+#ifdef RS485_USING_MODBUS
+    "rs485 mb_read [slave] [addr] [num]                      - read modbus holding registers.\n",
+    "rs485 mb_write [slave] [addr] [value]                   - write modbus single register.\n",
+#endif
+#ifdef RS485_USING_STATS
+    "rs485 stats [reset]                                     - show performance counters, reset--clear them.\n",
+#endif
+#ifdef RS485_USING_TRACE
+    "rs485 trace [hex|raw|clear]                             - dump trace ring decoded or as raw entries, or clear it.\n",
+#endif
+#ifdef RS485_USING_FRAME_HANDLER
+    "rs485 loop [period_ms]                                  - echo frames in an event loop and send a tick periodically, 0--stop.\n",
+#endif
+#ifdef RS485_USING_RTO
+    "rs485 rto [peer] [send_size] [recv_size]                - send_then_recv to peer by learned timeout, no peer--show learned values.\n",
+#endif
+#ifdef RS485_USING_SCHED
+    "rs485 sched [items] [period_ms] [seconds]               - poll slaves by scheduler, each item sends 'poll n' and receives a line.\n",
+#endif
+#ifdef RS485_USING_MODBUS_SLAVE
+    "rs485 mb_slave [addr]                                   - start modbus slave with 64 holding registers, 0--stop.\n",
+#endif
     "\n"
 };
 
+#ifdef RS485_USING_FRAME_HANDLER
+static rs485_loop_t test_loop;
+static rs485_loop_timer_t test_timer;
+static rt_uint8_t test_loop_stack[1024];
+static int test_loop_ticks = 0;
+
+static void test_loop_echo(rs485_inst_t * hinst, const rt_uint8_t *buf, int len, void *ctx)
+{
+    rs485_send(hinst, (void *)buf, len);
+}
+
+static void test_loop_tick(rs485_loop_timer_t *timer, void *ctx)
+{
+    char buf[16];
+    int len = rt_snprintf(buf, sizeof(buf), "tick %d\r\n", ++test_loop_ticks);
+    rs485_send((rs485_inst_t *)ctx, buf, len);
+}
+#endif
+
+#ifdef RS485_USING_SCHED
+#define TEST_SCHED_ITEMS        8
+
+static int test_sched_poll(rs485_inst_t * hinst, void *ctx)
+{
+    char req[16];
+    char rsp[32];
+    int len = rt_snprintf(req, sizeof(req), "poll %d\r\n", (int)(rt_ubase_t)ctx);
+    
+    len = rs485_send_then_recv_until(hinst, req, len, rsp, sizeof(rsp), "\r\n", 2);
+    if (len < 0)
+    {
+        return(len);
+    }
+    
+    return((len == 0) ? -RT_ETIMEOUT : RT_EOK);
+}
+#endif
+
 static void show_cmd_info(void)
 {
     for(int i=0; i<sizeof(cmd_info)/sizeof(char*); i++)
@@ -156,6 +253,46 @@ static void rs485_test(int argc, char **argv)
         return;
     }
     
+    if (strcmp(argv[1], "set_byte_tmo_us") == 0)
+    {
+        int tmo_us = 0;
+        if (argc >= 3)
+        {
+            tmo_us = atoi(argv[2]);
+        }
+        rs485_set_byte_tmo_us(test_hinst, tmo_us);
+        return;
+    }
+    
+    if (strcmp(argv[1], "set_sw_dly") == 0)
+    {
+        int pre_us = -1, post_us = -1;
+        if (argc >= 3)
+        {
+            pre_us = atoi(argv[2]);
+        }
+        if (argc >= 4)
+        {
+            post_us = atoi(argv[3]);
+        }
+        rs485_set_sw_dly(test_hinst, pre_us, post_us);
+        return;
+    }
+    
+    if (strcmp(argv[1], "set_rx_crc") == 0)
+    {
+        int type = RS485_CRC_NONE;
+        if (argc >= 3)
+        {
+            type = atoi(argv[2]);
+        }
+        if (rs485_set_rx_crc(test_hinst, type) == RT_EOK)
+        {
+            test_crc_type = type;
+        }
+        return;
+    }
+    
     if (strcmp(argv[1], "connect") == 0)
     {
         if (test_hinst == NULL)
@@ -163,7 +300,12 @@ static void rs485_test(int argc, char **argv)
             rt_kprintf("the test instance is NULL, please create first.\n");
             return;
         }
-        if (rs485_connect(test_hinst) == RT_EOK)
+        int flags = 0;
+        if (argc >= 3)
+        {
+            flags = atoi(argv[2]);
+        }
+        if (rs485_connect_ex(test_hinst, flags) == RT_EOK)
         {
             rt_kprintf("rs485 instance connect success.\n");
         }
@@ -211,9 +353,72 @@ static void rs485_test(int argc, char **argv)
             rt_kprintf("%02X ", test_buf[i]);
         }
         rt_kprintf("\n");
+        if (test_crc_type != RS485_CRC_NONE)
+        {
+            rt_uint32_t residue = (test_crc_type == RS485_CRC_16) ? RS485_CRC16_RESIDUE : RS485_CRC32_RESIDUE;
+            rt_kprintf("rs485 received frame crc %s .\n", (rs485_get_rx_crc(test_hinst) == residue) ? "ok" : "error");
+        }
+        return;
+    }
+    
+    if (strcmp(argv[1], "recv_line") == 0)
+    {
+        int size = RS485_TEST_BUF_SIZE - 1;
+        int len = 0;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            size = atoi(argv[2]);
+            if (size > RS485_TEST_BUF_SIZE - 1)
+            {
+                size = RS485_TEST_BUF_SIZE - 1;
+            }
+        }
+        rt_kprintf("rs485 start receiving a line, max length : %d .\n", size);
+        len = rs485_recv_until(test_hinst, test_buf, size, "\r\n", 2);
+        if (len <= 0)
+        {
+            rt_kprintf("rs485 receive line %s.\n", (len == 0) ? "timeout" : "fail");
+            return;
+        }
+        test_buf[len] = 0;
+        rt_kprintf("rs485 received line of %d datas : %s", len, test_buf);
         return;
     }
     
+#ifdef RS485_USING_FRAME_POOL
+    if (strcmp(argv[1], "recv_frame") == 0)
+    {
+        rs485_frame_t *frame = RT_NULL;
+        int len = 0;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        len = rs485_recv_frame(test_hinst, &frame);
+        if (len <= 0)
+        {
+            rt_kprintf("rs485 receive frame fail or timeout, result : %d .\n", len);
+            return;
+        }
+        rt_kprintf("rs485 received frame %d datas (hex) : ", len);
+        for (int i=0; i<len; i++)
+        {
+            rt_kprintf("%02X ", frame->data[i]);
+        }
+        rt_kprintf("\n");
+        rs485_frame_release(test_hinst, frame);
+        return;
+    }
+#endif
+    
     if (strcmp(argv[1], "send") == 0)
     {
         int size = RS485_TEST_BUF_SIZE;
@@ -240,6 +445,85 @@ static void rs485_test(int argc, char **argv)
         return;
     }
     
+    if (strcmp(argv[1], "sendv") == 0)
+    {
+        rs485_iovec_t iov[8];
+        int size = RS485_TEST_BUF_SIZE;
+        int segs = 3;
+        int pos = 0;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            size = atoi(argv[2]);
+            if (size > RS485_TEST_BUF_SIZE)
+            {
+                size = RS485_TEST_BUF_SIZE;
+            }
+        }
+        if (argc >= 4)
+        {
+            segs = atoi(argv[3]);
+        }
+        if (segs < 1 || segs > 8)
+        {
+            segs = 3;
+        }
+        for (int i=0; i<size; i++)
+        {
+            test_buf[i] = i;
+        }
+        for (int i=0; i<segs; i++)//split the buffer into segments
+        {
+            int len = (i == segs - 1) ? (size - pos) : (size / segs);
+            iov[i].base = test_buf + pos;
+            iov[i].len = len;
+            pos += len;
+        }
+        size = rs485_sendv(test_hinst, iov, segs);
+        rt_kprintf("rs485 transmit completed. length : %d .\n", size);
+        return;
+    }
+    
+    if (strcmp(argv[1], "send_async") == 0)
+    {
+        int size = RS485_TEST_BUF_SIZE;
+        rt_tick_t tick;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            size = atoi(argv[2]);
+            if (size > RS485_TEST_BUF_SIZE)
+            {
+                size = RS485_TEST_BUF_SIZE;
+            }
+        }
+        rs485_send_wait(test_hinst, RT_WAITING_FOREVER);//the buffer may be in use by last transmit
+        for (int i=0; i<size; i++)
+        {
+            test_buf[i] = i;
+        }
+        tick = rt_tick_get();
+        if (rs485_send_async(test_hinst, test_buf, size, RT_NULL, RT_NULL) != RT_EOK)
+        {
+            rt_kprintf("rs485 transmit asynchronously fail.\n");
+            return;
+        }
+        rt_kprintf("rs485 transmit queued in %d ticks.\n", rt_tick_get() - tick);
+        rs485_send_wait(test_hinst, RT_WAITING_FOREVER);
+        rt_kprintf("rs485 transmit completed in %d ticks. length : %d .\n", rt_tick_get() - tick, size);
+        return;
+    }
+    
     if (strcmp(argv[1], "cfg") == 0)
     {
         int baudrate = RS485_TEST_BAUDRATE;
@@ -311,6 +595,455 @@ static void rs485_test(int argc, char **argv)
         return;
     }
     
+    if (strcmp(argv[1], "send_then_recv_dl") == 0)
+    {
+        int send_size = RS485_TEST_BUF_SIZE;
+        int recv_size = RS485_TEST_BUF_SIZE;
+        int ms = 1000;
+        int len = 0;
+        rt_tick_t start;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            send_size = atoi(argv[2]);
+            if (send_size > RS485_TEST_BUF_SIZE)
+            {
+                send_size = RS485_TEST_BUF_SIZE;
+            }
+        }
+        if (argc >= 4)
+        {
+            recv_size = atoi(argv[3]);
+            if (recv_size > RS485_TEST_BUF_SIZE)
+            {
+                recv_size = RS485_TEST_BUF_SIZE;
+            }
+        }
+        if (argc >= 5)
+        {
+            ms = atoi(argv[4]);
+        }
+        for (int i=0; i<send_size; i++)
+        {
+            test_buf[i] = i;
+        }
+        rt_kprintf("rs485 send %d datas, then receive max length : %d within %d ms .\n", send_size, recv_size, ms);
+        start = rt_tick_get();
+        len = rs485_send_then_recv_dl(test_hinst, test_buf, send_size, test_buf, recv_size, RT_NULL, RT_NULL, 
+                                      start + rt_tick_from_millisecond(ms));
+        if (len <= 0)
+        {
+            rt_kprintf("rs485 transaction end by %s after %d ticks.\n", (len == 0) ? "timeout" : "error", rt_tick_get() - start);
+            return;
+        }
+        rt_kprintf("rs485 received %d datas after %d ticks (hex) : ", len, rt_tick_get() - start);
+        for (int i=0; i<len; i++)
+        {
+            rt_kprintf("%02X ", test_buf[i]);
+        }
+        rt_kprintf("\n");
+        return;
+    }
+    
+    if (strcmp(argv[1], "batch") == 0)
+    {
+        rs485_xfer_t xfers[8];
+        int count = 4;
+        int send_size = 8;
+        int recv_size = 64;
+        rt_tick_t tick;
+        int answered;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            count = atoi(argv[2]);
+        }
+        if (argc >= 4)
+        {
+            send_size = atoi(argv[3]);
+        }
+        if (argc >= 5)
+        {
+            recv_size = atoi(argv[4]);
+        }
+        if (count < 1 || count > 8 || send_size < 1 || recv_size < 0 || count * (send_size + recv_size) > RS485_TEST_BUF_SIZE)
+        {
+            rt_kprintf("batch param error, count 1-8, buffers of all transactions in %d bytes.\n", RS485_TEST_BUF_SIZE);
+            return;
+        }
+        for (int i=0; i<count; i++)//requests and responses are placed in test buffer in turn
+        {
+            char *p = test_buf + i * (send_size + recv_size);
+            for (int j=0; j<send_size; j++)
+            {
+                p[j] = i + j;
+            }
+            xfers[i].send_buf = p;
+            xfers[i].send_len = send_size;
+            xfers[i].recv_buf = p + send_size;
+            xfers[i].recv_size = recv_size;
+            xfers[i].timeout = 0;
+        }
+        tick = rt_tick_get();
+        answered = rs485_transact_batch(test_hinst, xfers, count);
+        rt_kprintf("rs485 batch completed in %d ticks, %d transactions answered.\n", rt_tick_get() - tick, answered);
+        for (int i=0; i<count; i++)
+        {
+            rt_kprintf("  transaction %d result : %d .\n", i, xfers[i].result);
+        }
+        return;
+    }
+    
+#ifdef RS485_USING_MODBUS
+    if (strcmp(argv[1], "mb_read") == 0)
+    {
+        static rt_uint16_t regs[RS485_MB_READ_REGS_MAX];
+        int slave = 1, addr = 0, num = 1;
+        int rc;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            slave = atoi(argv[2]);
+        }
+        if (argc >= 4)
+        {
+            addr = atoi(argv[3]);
+        }
+        if (argc >= 5)
+        {
+            num = atoi(argv[4]);
+        }
+        rc = rs485_mb_read_hold_regs(test_hinst, slave, addr, num, regs);
+        if (rc != RT_EOK)
+        {
+            rt_kprintf("modbus read fail, result : %d .\n", rc);
+            return;
+        }
+        rt_kprintf("modbus read %d registers (hex) : ", num);
+        for (int i=0; i<num; i++)
+        {
+            rt_kprintf("%04X ", regs[i]);
+        }
+        rt_kprintf("\n");
+        return;
+    }
+    
+    if (strcmp(argv[1], "mb_write") == 0)
+    {
+        int slave = 1, addr = 0, value = 0;
+        int rc;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            slave = atoi(argv[2]);
+        }
+        if (argc >= 4)
+        {
+            addr = atoi(argv[3]);
+        }
+        if (argc >= 5)
+        {
+            value = atoi(argv[4]);
+        }
+        rc = rs485_mb_write_reg(test_hinst, slave, addr, value);
+        rt_kprintf("modbus write register %s, result : %d .\n", (rc == RT_EOK) ? "success" : "fail", rc);
+        return;
+    }
+#endif
+    
+#ifdef RS485_USING_MODBUS_SLAVE
+    if (strcmp(argv[1], "mb_slave") == 0)
+    {
+        static rs485_mb_slave_t slave;
+        static rt_uint16_t regs[64];
+        static const rs485_mb_map_t map = {0, 64, regs, RT_NULL, RT_NULL, RT_NULL};
+        int addr = 1;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            addr = atoi(argv[2]);
+        }
+        if (addr == 0)
+        {
+            rs485_mb_slave_stop(&slave);
+            rt_kprintf("modbus slave stopped, %d requests, %d errors .\n", slave.msg_count, slave.err_count);
+            return;
+        }
+        if (rs485_mb_slave_init(&slave, test_hinst, addr) != RT_EOK
+            || rs485_mb_slave_set_map(&slave, RS485_MB_HOLD_REGS, &map, 1) != RT_EOK
+            || rs485_mb_slave_start(&slave) != RT_EOK)
+        {
+            rt_kprintf("modbus slave start fail.\n");
+            return;
+        }
+        rt_kprintf("modbus slave %d started.\n", addr);
+        return;
+    }
+#endif
+    
+#ifdef RS485_USING_STATS
+    if (strcmp(argv[1], "stats") == 0)
+    {
+        rs485_stats_t st;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3 && strcmp(argv[2], "reset") == 0)
+        {
+            rs485_reset_stats(test_hinst);
+            rt_kprintf("rs485 stats cleared.\n");
+            return;
+        }
+        rs485_get_stats(test_hinst, &st);
+        rt_kprintf("rs485 tx bytes          : %u \n", st.tx_bytes);
+        rt_kprintf("rs485 tx frames         : %u \n", st.tx_frames);
+        rt_kprintf("rs485 rx bytes          : %u \n", st.rx_bytes);
+        rt_kprintf("rs485 rx frames         : %u \n", st.rx_frames);
+        rt_kprintf("rs485 rx timeouts       : %u \n", st.rx_timeouts);
+        rt_kprintf("rs485 rx drops          : %u \n", st.rx_drops);
+        rt_kprintf("rs485 rx gap ends       : %u \n", st.rx_gap_ends);
+        rt_kprintf("rs485 rx breaks         : %u \n", st.rx_breaks);
+        rt_kprintf("rs485 mode switches     : %u \n", st.mode_switches);
+        rt_kprintf("rs485 lock takes        : %u \n", st.lock_takes);
+        rt_kprintf("rs485 lock wait         : %u us total, %u us max \n", (rt_uint32_t)st.lock_wait_us, st.lock_wait_max_us);
+        rt_kprintf("rs485 transactions      : %u \n", st.xfer_count);
+        rt_kprintf("rs485 latency           : %u / %u / %u us min / avg / max \n", 
+                    st.xfer_min_us, st.xfer_avg_us, st.xfer_max_us);
+        return;
+    }
+#endif
+    
+#ifdef RS485_USING_FRAME_HANDLER
+    if (strcmp(argv[1], "loop") == 0)
+    {
+        static int loop_inited = 0;
+        int period = 1000;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            period = atoi(argv[2]);
+        }
+        if ( ! loop_inited)
+        {
+            if (rs485_loop_init(&test_loop, "rs485t", test_loop_stack, sizeof(test_loop_stack), 10) != RT_EOK)
+            {
+                rt_kprintf("rs485 loop init fail.\n");
+                return;
+            }
+            loop_inited = 1;
+        }
+        if (period <= 0)
+        {
+            rs485_loop_timer_stop(&test_loop, &test_timer);
+            rs485_loop_remove(test_hinst);
+            rt_kprintf("rs485 loop stopped, %d ticks sent.\n", test_loop_ticks);
+            return;
+        }
+        if (rs485_loop_add(&test_loop, test_hinst, test_loop_echo, RT_NULL) != RT_EOK
+            || rs485_loop_timer_start(&test_loop, &test_timer, test_loop_tick, test_hinst, period, 1) != RT_EOK)
+        {
+            rt_kprintf("rs485 loop start fail.\n");
+            return;
+        }
+        test_loop_ticks = 0;
+        rt_kprintf("rs485 loop started, echo frames and send a tick every %d ms.\n", period);
+        return;
+    }
+#endif
+    
+#ifdef RS485_USING_SCHED
+    if (strcmp(argv[1], "sched") == 0)
+    {
+        static rs485_sched_t sched;
+        static rs485_poll_item_t items[TEST_SCHED_ITEMS];
+        int num = 4;
+        int period = 1000;
+        int seconds = 10;
+        rt_tick_t end;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            num = atoi(argv[2]);
+        }
+        if (argc >= 4)
+        {
+            period = atoi(argv[3]);
+        }
+        if (argc >= 5)
+        {
+            seconds = atoi(argv[4]);
+        }
+        if (num <= 0 || num > TEST_SCHED_ITEMS)
+        {
+            num = TEST_SCHED_ITEMS;
+        }
+        rs485_sched_init(&sched, test_hinst, 0);
+        for (int i = 0; i < num; i++)
+        {
+            rs485_sched_add(&sched, &items[i], test_sched_poll, (void *)(rt_ubase_t)i, period, i);
+        }
+        rt_kprintf("rs485 polling %d items every %d ms for %d seconds.\n", num, period, seconds);
+        end = rt_tick_get() + rt_tick_from_millisecond(seconds * 1000);
+        while ((rt_int32_t)(end - rt_tick_get()) > 0)
+        {
+            int tmo = rs485_sched_poll(&sched);
+            if (tmo > 0)
+            {
+                rt_thread_delay(tmo);
+            }
+        }
+        for (int i = 0; i < num; i++)
+        {
+            rs485_poll_stats_t *st = &items[i].stats;
+            rt_kprintf("item %d : polls %u, timeouts %u, errors %u, late avg %u max %u ticks\n", i, st->polls, 
+                        st->timeouts, st->errors, st->polls ? (st->late_sum / st->polls) : 0, st->late_max);
+        }
+        return;
+    }
+#endif
+    
+#ifdef RS485_USING_RTO
+    if (strcmp(argv[1], "rto") == 0)
+    {
+        rs485_rto_t entries[RS485_RTO_PEERS];
+        int send_size = RS485_TEST_BUF_SIZE;
+        int recv_size = RS485_TEST_BUF_SIZE;
+        int peer, len, cnt;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc < 3)
+        {
+            cnt = rs485_get_rto(test_hinst, entries, RS485_RTO_PEERS);
+            for (int i = 0; i < cnt; i++)
+            {
+                rs485_rto_t *e = &entries[i];
+                rt_kprintf("peer %-5d srtt %-8u rttvar %-8u rto %-5u ms samples %-8u timeouts %u \n", 
+                            e->peer, e->srtt_us, e->rttvar_us, e->rto_ms, e->samples, e->timeouts);
+            }
+            rt_kprintf("rs485 rto %d peers.\n", cnt);
+            return;
+        }
+        peer = atoi(argv[2]);
+        if (argc >= 4)
+        {
+            send_size = atoi(argv[3]);
+            if (send_size > RS485_TEST_BUF_SIZE)
+            {
+                send_size = RS485_TEST_BUF_SIZE;
+            }
+        }
+        if (argc >= 5)
+        {
+            recv_size = atoi(argv[4]);
+            if (recv_size > RS485_TEST_BUF_SIZE)
+            {
+                recv_size = RS485_TEST_BUF_SIZE;
+            }
+        }
+        for (int i=0; i<send_size; i++)
+        {
+            test_buf[i] = i;
+        }
+        len = rs485_send_then_recv_peer(test_hinst, peer, test_buf, send_size, test_buf, recv_size);
+        if (len == 0)
+        {
+            rt_kprintf("rs485 peer %d receive timeout.\n", peer);
+            return;
+        }
+        rt_kprintf("rs485 peer %d received %d datas.\n", peer, len);
+        return;
+    }
+#endif
+    
+#ifdef RS485_USING_TRACE
+    if (strcmp(argv[1], "trace") == 0)
+    {
+        static rs485_trace_t entries[RS485_TRACE_NUM];
+        int raw = 0;
+        int cnt;
+        
+        if (test_hinst == NULL)
+        {
+            rt_kprintf("the test instance is NULL, please create first.\n");
+            return;
+        }
+        if (argc >= 3)
+        {
+            if (strcmp(argv[2], "clear") == 0)
+            {
+                rs485_clear_trace(test_hinst);
+                rt_kprintf("rs485 trace cleared.\n");
+                return;
+            }
+            raw = (strcmp(argv[2], "raw") == 0);
+        }
+        cnt = rs485_get_trace(test_hinst, entries, RS485_TRACE_NUM);
+        for (int i = 0; i < cnt; i++)
+        {
+            rs485_trace_t *t = &entries[i];
+            if (raw)//entry bytes in host order, one entry a line
+            {
+                for (int j = 0; j < sizeof(rs485_trace_t); j++)
+                {
+                    rt_kprintf("%02x", ((rt_uint8_t *)t)[j]);
+                }
+                rt_kprintf("\n");
+                continue;
+            }
+            rt_kprintf("%10u %s len %-4d result %-3d : ", t->stamp, (t->dir == RS485_TRACE_TX) ? "tx" : "rx", t->len, t->result);
+            for (int j = 0; j < t->cnt; j++)
+            {
+                rt_kprintf("%02x ", t->data[j]);
+            }
+            rt_kprintf("%s\n", (t->cnt < t->len) ? "..." : "");
+        }
+        rt_kprintf("rs485 trace %d entries.\n", cnt);
+        return;
+    }
+#endif
+    
     rt_kprintf("error ! unsupported command .\n");
 }
 MSH_CMD_EXPORT_ALIAS(rs485_test, rs485, test rs485 module functions);